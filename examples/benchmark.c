@@ -0,0 +1,495 @@
+/*
+ By: Justin Meiners
+
+ Copyright (c) 2013 Inline Studios
+ Licensed under the MIT license: http://www.opensource.org/licenses/mit-license.php
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Console.h"
+#include "ConsoleStdLib.h"
+
+#define LOOKUP_ITERATIONS 1000000
+
+static double _Seconds(clock_t start, clock_t end)
+{
+    return (double)(end - start) / (double)CLOCKS_PER_SEC;
+}
+
+/* time Console_FindVar against a console holding symbolCount vars */
+static void _BenchmarkLookup(int symbolCount)
+{
+    ConsoleRef console = Console_Create(stdout);
+    Console_Reserve(console, symbolCount, 0);
+
+    char (*names)[32] = malloc(sizeof(*names) * symbolCount);
+
+    int i;
+    for (i = 0; i < symbolCount; i ++)
+    {
+        sprintf(names[i], "bench_var_%i", i);
+        Console_RegisterVar(console, names[i], kConsoleVarTypeInt, 0);
+    }
+
+    int found = 0;
+    unsigned int next = 0;
+
+    clock_t start = clock();
+    for (i = 0; i < LOOKUP_ITERATIONS; i ++)
+    {
+        /* spread lookups over the whole table */
+        next = (next + 7919) % (unsigned int)symbolCount;
+        found += Console_FindVar(console, names[next]) != NULL;
+    }
+    clock_t end = clock();
+
+    printf("lookup %7i symbols: %8.1f ns/lookup (%i found)\n",
+           symbolCount,
+           _Seconds(start, end) * 1e9 / (double)LOOKUP_ITERATIONS,
+           found);
+
+    free(names);
+    Console_Destroy(console);
+}
+
+#define LITERAL_ITERATIONS 200000
+
+static int _Ignore(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    return 1;
+}
+
+/* the classifier literals used before, strtol to tell ints from doubles then sscanf */
+static int _OldLiteral(const char* token, int* outInt, double* outDouble)
+{
+    char* ep = NULL;
+    strtol(token, &ep, 10);
+
+    if (*ep == 'e' || *ep == 'E' || *ep == '.')
+    {
+        return sscanf(token, "%lf", outDouble) == 1;
+    }
+
+    return sscanf(token, "%d", outInt) == 1;
+}
+
+/* time binding numeric literals taken from config files */
+static void _BenchmarkLiterals(void)
+{
+    static const char* lines[] = {
+        "cfg 90 1.2 0.75 60",
+        "cfg 1920 1080 144 0",
+        "cfg 2.2 1e-3 0.0001 100.5",
+        "cfg 0xFF00FF 0x7F 1024 4096",
+        "cfg 1 0 1 1 0 0 1",
+        "cfg 0.333333 16.6667 3.14159265 2.71828",
+    };
+    int lineCount = (int)(sizeof(lines) / sizeof(lines[0]));
+
+    ConsoleRef console = Console_Create(stdout);
+    Console_RegisterCommandArgv(console, "cfg", _Ignore, -1);
+
+    int i;
+    clock_t start = clock();
+    for (i = 0; i < LITERAL_ITERATIONS; i ++)
+    {
+        Console_Execute(console, lines[i % lineCount]);
+    }
+    clock_t end = clock();
+
+    double execute = _Seconds(start, end);
+
+    /* baseline, only classifying each line's literals the old way */
+    char tokens[sizeof(lines) / sizeof(lines[0])][8][32];
+    int tokenCounts[sizeof(lines) / sizeof(lines[0])];
+    for (i = 0; i < lineCount; i ++)
+    {
+        char line[128];
+        strcpy(line, lines[i]);
+
+        tokenCounts[i] = 0;
+        char* token = strtok(line, " ");
+        for (token = strtok(NULL, " "); token; token = strtok(NULL, " "))
+        {
+            strcpy(tokens[i][tokenCounts[i]++], token);
+        }
+    }
+
+    int intValue = 0;
+    double doubleValue = 0.0;
+    int converted = 0;
+
+    start = clock();
+    for (i = 0; i < LITERAL_ITERATIONS; i ++)
+    {
+        int line = i % lineCount;
+        int j;
+        for (j = 0; j < tokenCounts[line]; j ++)
+        {
+            converted += _OldLiteral(tokens[line][j], &intValue, &doubleValue);
+        }
+    }
+    end = clock();
+
+    printf("execute config lines: %8.1f ns/line, strtol + sscanf alone: %8.1f ns/line (%i converted)\n",
+           execute * 1e9 / (double)LITERAL_ITERATIONS,
+           _Seconds(start, end) * 1e9 / (double)LITERAL_ITERATIONS,
+           converted);
+
+    Console_Destroy(console);
+}
+
+#define FORMAT_VALUES 100000
+
+/* time Console_FormatDouble against the stdio formats */
+static void _BenchmarkFormat(void)
+{
+    double* values = malloc(sizeof(double) * FORMAT_VALUES);
+    char buffer[CONSOLE_NUMBER_STRING_MAX];
+    size_t total = 0;
+
+    int i;
+    for (i = 0; i < FORMAT_VALUES; i ++)
+    {
+        values[i] = (double)rand() / (double)RAND_MAX * 1000.0;
+    }
+
+    clock_t start = clock();
+    for (i = 0; i < FORMAT_VALUES; i ++)
+    {
+        total += (size_t)Console_FormatDouble(values[i], buffer);
+    }
+    clock_t end = clock();
+    double shortest = _Seconds(start, end);
+
+    start = clock();
+    for (i = 0; i < FORMAT_VALUES; i ++)
+    {
+        total += (size_t)snprintf(buffer, sizeof(buffer), "%.17g", values[i]);
+    }
+    end = clock();
+    double exact = _Seconds(start, end);
+
+    start = clock();
+    for (i = 0; i < FORMAT_VALUES; i ++)
+    {
+        total += (size_t)snprintf(buffer, sizeof(buffer), "%lf", values[i]);
+    }
+    end = clock();
+
+    printf("format %i doubles: shortest %6.2f ms, %%.17g %6.2f ms, %%lf %6.2f ms (%i chars)\n",
+           FORMAT_VALUES,
+           shortest * 1e3,
+           exact * 1e3,
+           _Seconds(start, end) * 1e3,
+           (int)total);
+
+    free(values);
+}
+
+/* time text Console_Load against Console_LoadSnapshot for varCount vars */
+static void _BenchmarkLoad(int varCount)
+{
+    ConsoleRef console = Console_Create(stdout);
+    Console_Reserve(console, varCount, 0);
+
+    char name[32];
+    int i;
+    for (i = 0; i < varCount; i ++)
+    {
+        sprintf(name, "bench_var_%i", i);
+        ConsoleVarRef var = Console_RegisterVar(console, name, (i % 2) ? kConsoleVarTypeDouble : kConsoleVarTypeInt, 0);
+
+        if (i % 2)
+        {
+            ConsoleVar_SetDoubleValue(var, (double)i * 0.5);
+        }
+        else
+        {
+            ConsoleVar_SetIntValue(var, i);
+        }
+    }
+
+    FILE* textFile = fopen("bench.cfg", "w");
+    Console_Save(console, textFile);
+    fclose(textFile);
+
+    FILE* snapshotFile = fopen("bench.snapshot", "wb");
+    Console_SaveSnapshot(console, snapshotFile);
+    fclose(snapshotFile);
+
+    clock_t start = clock();
+    textFile = fopen("bench.cfg", "r");
+    Console_Load(console, textFile);
+    fclose(textFile);
+    clock_t end = clock();
+
+    double textSeconds = _Seconds(start, end);
+
+    start = clock();
+    Console_LoadSnapshot(console, "bench.snapshot");
+    end = clock();
+
+    printf("load %7i vars: text %8.3f ms, snapshot %8.3f ms\n",
+           varCount,
+           textSeconds * 1e3,
+           _Seconds(start, end) * 1e3);
+
+    remove("bench.cfg");
+    remove("bench.snapshot");
+    Console_Destroy(console);
+}
+
+#define COMPLETE_ITERATIONS 100000
+
+static void _CountName(const char* name, unsigned int symbols, void* context)
+{
+    ++*(int*)context;
+}
+
+/* prefix queries against a large registry */
+static void _BenchmarkComplete(int symbolCount)
+{
+    ConsoleRef console = Console_Create(stdout);
+    Console_Reserve(console, symbolCount, 0);
+
+    char name[32];
+    int i;
+    for (i = 0; i < symbolCount; i ++)
+    {
+        sprintf(name, "bench_%c_var_%i", 'a' + i % 26, i);
+        Console_RegisterVar(console, name, kConsoleVarTypeInt, 0);
+    }
+
+    /* the first query sorts the registrations */
+    clock_t start = clock();
+    int found = 0;
+    Console_Complete(console, "", _CountName, &found);
+    clock_t end = clock();
+
+    double sortSeconds = _Seconds(start, end);
+
+    found = 0;
+    start = clock();
+    for (i = 0; i < COMPLETE_ITERATIONS; i ++)
+    {
+        sprintf(name, "bench_%c_var_%i", 'a' + i % 26, i % 100);
+        Console_Complete(console, name, _CountName, &found);
+    }
+    end = clock();
+
+    printf("complete %7i symbols: first %8.3f ms, then %8.1f ns/query (%i found)\n",
+           symbolCount,
+           sortSeconds * 1e3,
+           _Seconds(start, end) * 1e9 / (double)COMPLETE_ITERATIONS,
+           found);
+
+    Console_Destroy(console);
+}
+
+#define RECORD_FRAMES 100000
+
+/* execute a few commands a frame with recording off, on, then replay them */
+static void _BenchmarkRecord(void)
+{
+    static const char* lines[] = {
+        "cfg 90 1.2",
+        "cfg 1920 1080",
+        "cfg \"player one\"",
+        "cfg 1 0 1",
+    };
+    int lineCount = (int)(sizeof(lines) / sizeof(lines[0]));
+    double seconds[2];
+
+    int pass;
+    for (pass = 0; pass < 2; pass ++)
+    {
+        ConsoleRef console = Console_Create(stdout);
+        Console_RegisterCommandArgv(console, "cfg", _Ignore, -1);
+
+        FILE* file = fopen("bench.rec", "wb");
+
+        if (pass == 1)
+        {
+            Console_StartRecording(console, file);
+        }
+
+        clock_t start = clock();
+        int i;
+        for (i = 0; i < RECORD_FRAMES; i ++)
+        {
+            Console_SetFrame(console, (unsigned int)i);
+            Console_Execute(console, lines[i % lineCount]);
+            Console_Execute(console, lines[(i / 3) % lineCount]);
+        }
+        Console_StopRecording(console);
+        clock_t end = clock();
+
+        seconds[pass] = _Seconds(start, end);
+        fclose(file);
+        Console_Destroy(console);
+    }
+
+    ConsoleRef console = Console_Create(stdout);
+    Console_RegisterCommandArgv(console, "cfg", _Ignore, -1);
+
+    clock_t start = clock();
+    ConsoleReplayRef replay = ConsoleReplay_Open(console, "bench.rec");
+    unsigned int frame;
+    int replayed = 0;
+    while (ConsoleReplay_NextFrame(replay, &frame))
+    {
+        Console_SetFrame(console, frame);
+        replayed += ConsoleReplay_RunFrame(replay, frame);
+    }
+    ConsoleReplay_Close(replay);
+    clock_t end = clock();
+
+    printf("record %i commands: %8.1f ns/command off, %8.1f on, replay %8.1f\n",
+           replayed,
+           seconds[0] * 1e9 / (double)(RECORD_FRAMES * 2),
+           seconds[1] * 1e9 / (double)(RECORD_FRAMES * 2),
+           _Seconds(start, end) * 1e9 / (double)replayed);
+
+    remove("bench.rec");
+    Console_Destroy(console);
+}
+
+#define SNAPSHOT_ITERATIONS 10000
+
+/* snapshot and restore cost follows the vars changed, not the vars registered */
+static void _BenchmarkSnapshot(int varCount)
+{
+    ConsoleRef console = Console_Create(stdout);
+    Console_Reserve(console, varCount, 0);
+
+    ConsoleVarRef* vars = malloc(sizeof(ConsoleVarRef) * (size_t)varCount);
+    char name[32];
+    int i;
+    for (i = 0; i < varCount; i ++)
+    {
+        sprintf(name, "bench_var_%i", i);
+        vars[i] = Console_RegisterVar(console, name, kConsoleVarTypeInt, 0);
+    }
+
+    clock_t start = clock();
+    for (i = 0; i < SNAPSHOT_ITERATIONS; i ++)
+    {
+        ConsoleVarSnapshotRef snapshot = Console_Snapshot(console);
+        ConsoleVar_SetIntValue(vars[i % varCount], i + 1);
+        ConsoleVar_SetIntValue(vars[(i * 7) % varCount], i + 2);
+        Console_Restore(console, snapshot);
+        Console_ReleaseSnapshot(snapshot);
+    }
+    clock_t end = clock();
+
+    printf("snapshot %7i vars: %8.1f ns/snapshot, 2 changes, restore\n",
+           varCount,
+           _Seconds(start, end) * 1e9 / (double)SNAPSHOT_ITERATIONS);
+
+    free(vars);
+    Console_Destroy(console);
+}
+
+#define SCHEDULE_COUNT 100000
+
+static void _BenchmarkSchedule(void)
+{
+    ConsoleRef console = Console_Create(stdout);
+    Console_RegisterCommandArgv(console, "cfg", _Ignore, -1);
+
+    ConsoleTimerId_t* ids = malloc(sizeof(ConsoleTimerId_t) * SCHEDULE_COUNT);
+
+    clock_t start = clock();
+    int i;
+    for (i = 0; i < SCHEDULE_COUNT; i ++)
+    {
+        ids[i] = Console_ExecuteAt(console, "cfg 1", (unsigned int)(i * 7919) % 1000000);
+    }
+    clock_t scheduled = clock();
+
+    for (i = 0; i < SCHEDULE_COUNT; i += 2)
+    {
+        Console_Cancel(console, ids[i]);
+    }
+    clock_t cancelled = clock();
+
+    int ran = 0;
+    unsigned int frame;
+    for (frame = 0; frame < 1000000; frame ++)
+    {
+        ran += Console_Tick(console, frame);
+    }
+    clock_t end = clock();
+
+    printf("schedule %i commands: %8.1f ns/schedule, %8.1f ns/cancel, %8.1f ns/tick running %i\n",
+           SCHEDULE_COUNT,
+           _Seconds(start, scheduled) * 1e9 / (double)SCHEDULE_COUNT,
+           _Seconds(scheduled, cancelled) * 1e9 / (double)(SCHEDULE_COUNT / 2),
+           _Seconds(cancelled, end) * 1e9 / 1000000.0,
+           ran);
+
+    free(ids);
+    Console_Destroy(console);
+}
+
+#define KEY_ITERATIONS 1000000
+
+/* a bound key against executing the same text */
+static void _BenchmarkKeys(void)
+{
+    ConsoleRef console = Console_Create(stdout);
+    Console_RegisterCommandArgv(console, "cfg", _Ignore, -1);
+    Console_BindKey(console, 32, "cfg 90 1.2");
+
+    clock_t start = clock();
+    int i;
+    for (i = 0; i < KEY_ITERATIONS; i ++)
+    {
+        Console_Execute(console, "cfg 90 1.2");
+    }
+    clock_t executed = clock();
+
+    for (i = 0; i < KEY_ITERATIONS; i ++)
+    {
+        Console_KeyEvent(console, 32, 1);
+    }
+    clock_t end = clock();
+
+    printf("key press: %8.1f ns executed, %8.1f ns bound\n",
+           _Seconds(start, executed) * 1e9 / (double)KEY_ITERATIONS,
+           _Seconds(executed, end) * 1e9 / (double)KEY_ITERATIONS);
+
+    Console_Destroy(console);
+}
+
+int main(int argc, const char * argv[])
+{
+    _BenchmarkLookup(100);
+    _BenchmarkLookup(1000);
+    _BenchmarkLookup(100000);
+
+    _BenchmarkLiterals();
+    _BenchmarkFormat();
+
+    _BenchmarkLoad(1000);
+    _BenchmarkLoad(50000);
+
+    _BenchmarkComplete(1000);
+    _BenchmarkComplete(100000);
+
+    _BenchmarkRecord();
+
+    _BenchmarkSnapshot(1000);
+    _BenchmarkSnapshot(100000);
+
+    _BenchmarkSchedule();
+
+    _BenchmarkKeys();
+
+    return 0;
+}
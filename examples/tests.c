@@ -5,12 +5,1035 @@
  Licensed under the MIT license: http://www.opensource.org/licenses/mit-license.php
  */
 
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <locale.h>
 
 #include "Console.h"
 #include "ConsoleStdLib.h"
 
+#ifndef CONSOLE_NO_THREADS
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+static int allocationCount = 0;
+
+static void* _CountingMalloc(size_t size)
+{
+    allocationCount++;
+    return malloc(size);
+}
+
+#ifndef CONSOLE_NO_THREADS
+#define PRODUCER_THREADS 4
+#define PRODUCER_COMMANDS 10000
+
+static int queuedCount = 0;
+
+static int _Count(ConsoleRef console, ConsoleArgRef args)
+{
+    queuedCount++;
+    return 1;
+}
+
+static void* _Producer(void* context)
+{
+    ConsoleRef console = context;
+    
+    int i;
+    for (i = 0; i < PRODUCER_COMMANDS; i ++)
+    {
+        /* spin while the console thread catches up */
+        while (Console_Enqueue(console, "count") == 0)
+        {
+        }
+    }
+    
+    return NULL;
+}
+
+/* several threads submit while the main thread drains */
+static void _TestQueue(ConsoleRef console)
+{
+    Console_RegisterCommand(console, "count", _Count, 0);
+    
+    pthread_t producers[PRODUCER_THREADS];
+    
+    int i;
+    for (i = 0; i < PRODUCER_THREADS; i ++)
+    {
+        pthread_create(&producers[i], NULL, _Producer, console);
+    }
+    
+    while (queuedCount < PRODUCER_THREADS * PRODUCER_COMMANDS)
+    {
+        Console_DrainQueue(console, 64, 1000);
+    }
+    
+    for (i = 0; i < PRODUCER_THREADS; i ++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    
+    assert(Console_DrainQueue(console, 0, 0) == 0);
+    assert(queuedCount == PRODUCER_THREADS * PRODUCER_COMMANDS);
+    
+    /* too long never fits, unlike a full queue */
+    char command[CONSOLE_QUEUE_COMMAND_MAX + 1];
+    memset(command, ' ', sizeof(command) - 1);
+    memcpy(command, "count", 5);
+    command[sizeof(command) - 1] = '\0';
+    assert(Console_Enqueue(console, command) == -1);
+    command[sizeof(command) - 2] = '\0';
+    assert(Console_Enqueue(console, command) == 1);
+    assert(Console_DrainQueue(console, 0, 0) == 1);
+}
+
+#define READER_THREADS 4
+#define WRITER_ITERATIONS 20000
+
+static atomic_int readersDone;
+
+static void* _Reader(void* context)
+{
+    ConsoleRef console = context;
+    ConsoleVarRef volume = Console_FindVar(console, "snd_volume");
+    ConsoleVarRef vsync = Console_FindVar(console, "r_vsync");
+    ConsoleVarRef map = Console_FindVar(console, "map");
+    
+    char buffer[CONSOLE_VAR_CONCURRENT_STRING_MAX];
+    
+    while (!atomic_load(&readersDone))
+    {
+        double v = ConsoleVar_DoubleValue(volume);
+        assert(v == 0.0 || v == 0.25 || v == 0.75);
+        
+        int i = ConsoleVar_IntValue(vsync);
+        assert(i == 0 || i == 1);
+        
+        /* values are all one letter, a torn read would mix them */
+        ConsoleVar_CopyStringValue(map, buffer, sizeof(buffer));
+        size_t length = strlen(buffer);
+        size_t j;
+        for (j = 1; j < length; j ++)
+        {
+            assert(buffer[j] == buffer[0]);
+        }
+        assert(length == 0 || (buffer[0] == 'a' && length == 200) || (buffer[0] == 'b' && length == 20));
+    }
+    
+    return NULL;
+}
+
+/* readers on other threads while the console thread writes */
+static void _TestConcurrentReads(ConsoleRef console)
+{
+    Console_RegisterVar(console, "snd_volume", kConsoleVarTypeDouble, kConsoleVarFlagConcurrent);
+    Console_RegisterVar(console, "r_vsync", kConsoleVarTypeBool, kConsoleVarFlagConcurrent);
+    ConsoleVarRef map = Console_RegisterVar(console, "map", kConsoleVarTypeString, kConsoleVarFlagConcurrent);
+    
+    char longValue[201];
+    memset(longValue, 'a', 200);
+    longValue[200] = '\0';
+    
+    atomic_store(&readersDone, 0);
+    
+    pthread_t readers[READER_THREADS];
+    
+    int i;
+    for (i = 0; i < READER_THREADS; i ++)
+    {
+        pthread_create(&readers[i], NULL, _Reader, console);
+    }
+    
+    for (i = 0; i < WRITER_ITERATIONS; i ++)
+    {
+        if (i % 2)
+        {
+            Console_Execute(console, "set snd_volume 0.25");
+            Console_Execute(console, "set r_vsync TRUE");
+            Console_Execute(console, "set map \"bbbbbbbbbbbbbbbbbbbb\"");
+        }
+        else
+        {
+            Console_Execute(console, "set snd_volume 0.75");
+            Console_Execute(console, "set r_vsync FALSE");
+            ConsoleVar_SetStringValue(map, longValue);
+        }
+    }
+    
+    atomic_store(&readersDone, 1);
+    
+    for (i = 0; i < READER_THREADS; i ++)
+    {
+        pthread_join(readers[i], NULL);
+    }
+    
+    /* last write was odd */
+    assert(strcmp(ConsoleVar_StringValue(map), "bbbbbbbbbbbbbbbbbbbb") == 0);
+    assert(ConsoleVar_DoubleValue(Console_FindVar(console, "snd_volume")) == 0.25);
+}
+
+#define RING_LINES 20000
+
+static atomic_int ringDone;
+
+/* checks each line it sees is one whole line as written */
+static void* _RingReader(void* context)
+{
+    ConsoleLogRingRef ring = context;
+    unsigned long long next = 0;
+    
+    while (!atomic_load(&ringDone))
+    {
+        unsigned long long line = ConsoleLogRing_BeginRead(ring, next);
+        unsigned long long count = ConsoleLogRing_LineCount(ring);
+        
+        for (; line < count; line ++)
+        {
+            size_t length;
+            const char* text = ConsoleLogRing_Line(ring, line, &length);
+            
+            int n = atoi(text);
+            const char* letters = memchr(text, ':', length);
+            assert(letters);
+            
+            size_t letterCount = length - (size_t)(letters + 1 - text);
+            assert(letterCount == (size_t)(n % 50));
+            
+            size_t j;
+            for (j = 0; j < letterCount; j ++)
+            {
+                assert(letters[1 + j] == 'a' + n % 26);
+            }
+        }
+        
+        ConsoleLogRing_EndRead(ring);
+        next = count;
+    }
+    
+    return NULL;
+}
+
+static void _TestLogRing(ConsoleRef console)
+{
+    ConsoleLogRingRef ring = ConsoleLogRing_Create(1024);
+    assert(ring);
+    Console_SetOutput(console, ConsoleLogRing_Write, ring);
+    
+    atomic_store(&ringDone, 0);
+    pthread_t reader;
+    pthread_create(&reader, NULL, _RingReader, ring);
+    
+    char letters[50];
+    
+    int i;
+    for (i = 0; i < RING_LINES; i ++)
+    {
+        memset(letters, 'a' + i % 26, sizeof(letters));
+        /* split writes, the line is only published at the newline */
+        Console_Printf(console, "%i:", i);
+        Console_Printf(console, "%.*s\n", i % 50, letters);
+    }
+    
+    atomic_store(&ringDone, 1);
+    pthread_join(reader, NULL);
+    
+    /* old lines were overwritten, the newest are intact */
+    Console_Execute(console, "echo \"last line\"");
+    unsigned long long count = ConsoleLogRing_LineCount(ring);
+    assert(count + ConsoleLogRing_Dropped(ring) == RING_LINES + 1);
+    
+    unsigned long long first = ConsoleLogRing_BeginRead(ring, 0);
+    assert(first > 0);
+    size_t length;
+    const char* text = ConsoleLogRing_Line(ring, count - 1, &length);
+    assert(length == 9 && memcmp(text, "last line", 9) == 0);
+    ConsoleLogRing_EndRead(ring);
+    
+    Console_SetOutput(console, NULL, NULL);
+    ConsoleLogRing_Destroy(ring);
+}
+#endif
+
+static double lastAverage = 0.0;
+
+static int _Average(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    double total = 0.0;
+    
+    int i;
+    for (i = 0; i < argc; i ++)
+    {
+        total += ConsoleArgView_DoubleValue(&argv[i]);
+    }
+    
+    lastAverage = total / (double)argc;
+    return 1;
+}
+
+static int _SumList(ConsoleRef console, ConsoleArgRef args)
+{
+    double total = 0.0;
+    
+    for (; args; args = args->next)
+    {
+        total += ConsoleVar_DoubleValue(args->var);
+    }
+    
+    lastAverage = total;
+    return 1;
+}
+
+static int spawnCount = 0;
+static int spawnTeam = 0;
+static double spawnHealth = 0.0;
+
+static int _Spawn(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    assert(argv[0].type == kConsoleVarTypeInt);
+    assert(argv[1].type == kConsoleVarTypeDouble);
+    assert(argv[2].type == kConsoleVarTypeString);
+    
+    spawnTeam = argv[0].value.intValue;
+    spawnHealth = argv[1].value.doubleValue;
+    spawnCount++;
+    return 1;
+}
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+static int savesDone = 0;
+
+static void _SaveDone(ConsoleRef console, const char* path, int success, void* context)
+{
+    assert(success);
+    assert(strcmp(path, "tests.cfg") == 0);
+    savesDone++;
+}
+#endif
+
+static int gammaChanges = 0;
+
+static void _GammaChanged(ConsoleVarRef var, void* context)
+{
+    gammaChanges++;
+    assert(context == &gammaChanges);
+}
+
+/* multi statement scripts, errors carry line numbers */
+static int _Fail(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    return 0;
+}
+
+static void _TestScripts(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    
+    ConsoleVarRef a = Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    ConsoleVarRef b = Console_RegisterVar(console, "b", kConsoleVarTypeString, 0);
+    
+    const char script[] =
+        "# settings\n"
+        "set a 1; set a 2 // comment\n"
+        "\n"
+        "bogus 1\n"
+        "set b \"x;y\"\n"
+        "set a 3";
+    
+    assert(!Console_ExecuteScript(console, script, sizeof(script) - 1));
+    assert(ConsoleVar_IntValue(a) == 3);
+    assert(strcmp(ConsoleVar_StringValue(b), "x;y") == 0);
+    
+    /* failing handlers and bad argument counts fail the script too */
+    Console_RegisterCommandArgv(console, "fail", _Fail, 0);
+    assert(!Console_ExecuteScript(console, "fail\n", 5));
+    assert(!Console_ExecuteScript(console, "fail 1 2\n", 9));
+    assert(Console_ExecuteScript(console, "set a 3\n", 8));
+    
+    /* Console_Execute reports only whether the command ran */
+    assert(Console_Execute(console, "fail"));
+    
+    /* and runs nothing given more than one statement */
+    assert(!Console_Execute(console, "set a 4; set a 5"));
+    assert(ConsoleVar_IntValue(a) == 3);
+    assert(Console_Execute(console, "set a 4;"));
+    assert(ConsoleVar_IntValue(a) == 4);
+    
+    /* no line length limit, and no terminator needed */
+    char line[1024];
+    memset(line, ' ', sizeof(line));
+    memcpy(line, "set a 7", 7);
+    assert(Console_ExecuteScript(console, line, sizeof(line)));
+    assert(ConsoleVar_IntValue(a) == 7);
+    
+    FILE* file = fopen("tests.script", "w");
+    fputs("set a 8\nset b \"from a file\"\n", file);
+    fclose(file);
+    assert(Console_ExecuteFile(console, "tests.script"));
+    assert(ConsoleVar_IntValue(a) == 8);
+    assert(strcmp(ConsoleVar_StringValue(b), "from a file") == 0);
+    remove("tests.script");
+    
+    char output[256];
+    int foundError = 0;
+    rewind(log);
+    while (fgets(output, sizeof(output), log))
+    {
+        foundError |= strcmp(output, "script:4: unknown command: bogus\n") == 0;
+    }
+    assert(foundError);
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
+static void _CollectName(const char* name, unsigned int symbols, void* context)
+{
+    char* names = context;
+    strcat(names, name);
+    strcat(names, (symbols & kConsoleSymbolCommand) ? "() " : " ");
+}
+
+static void _TestNames(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    
+    Console_RegisterVar(console, "r_vsync", kConsoleVarTypeBool, 0);
+    Console_RegisterVar(console, "snd_volume", kConsoleVarTypeDouble, 0);
+    Console_RegisterVar(console, "r_fov", kConsoleVarTypeDouble, 0);
+    Console_RegisterVar(console, "r_gamma", kConsoleVarTypeDouble, 0);
+    Console_RegisterCommand(console, "r_restart", _SumList, -1);
+    /* shadowing and sharing a name don't list it twice */
+    Console_RegisterVar(console, "r_fov", kConsoleVarTypeInt, 0);
+    Console_RegisterCommand(console, "r_gamma", _SumList, -1);
+    
+    char names[256];
+    
+    names[0] = '\0';
+    assert(Console_Complete(console, "r_", _CollectName, names) == 4);
+    assert(strcmp(names, "r_fov r_gamma() r_restart() r_vsync ") == 0);
+    
+    /* registered after a query */
+    Console_RegisterVar(console, "r_aspect", kConsoleVarTypeDouble, 0);
+    Console_RegisterVar(console, "r_fov", kConsoleVarTypeDouble, 0);
+    names[0] = '\0';
+    assert(Console_Complete(console, "r_", _CollectName, names) == 5);
+    assert(strcmp(names, "r_aspect r_fov r_gamma() r_restart() r_vsync ") == 0);
+    
+    names[0] = '\0';
+    assert(Console_Complete(console, "r_g", _CollectName, names) == 1);
+    assert(Console_Complete(console, "x", _CollectName, names) == 0);
+    assert(Console_Complete(console, "", _CollectName, names) > 4);
+    
+    names[0] = '\0';
+    assert(Console_List(console, "r_*a*", _CollectName, names) == 3);
+    assert(strcmp(names, "r_aspect r_gamma() r_restart() ") == 0);
+    
+    names[0] = '\0';
+    assert(Console_List(console, "*_v?l*", _CollectName, names) == 1);
+    assert(strcmp(names, "snd_volume ") == 0);
+    
+    assert(Console_List(console, "r_fov", _CollectName, names) == 1);
+    assert(Console_List(console, "r_fo", _CollectName, names) == 0);
+    
+    assert(Console_Execute(console, "list \"r_*\""));
+    assert(Console_Execute(console, "list r_fov"));
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
+#ifdef CONSOLE_PROFILE
+static void _TestStats(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    
+    int i;
+    for (i = 0; i < 100; i ++)
+    {
+        assert(Console_Execute(console, "set a 1"));
+    }
+    
+    /* wrong argument count, then unbindable arguments */
+    Console_Execute(console, "set a");
+    assert(!Console_Execute(console, "set a nothing"));
+    
+    ConsoleCompiledRef compiled = Console_Compile(console, "set a 2");
+    Console_Run(compiled);
+    
+    ConsoleCommandStats_t stats;
+    assert(Console_GetStats(console, "set", &stats));
+    assert(strcmp(stats.name, "set") == 0);
+    assert(stats.calls == 103);
+    assert(stats.failures == 2);
+    assert(stats.parse.count == 102);
+    assert(stats.lookup.count == 102);
+    assert(stats.handler.count == 101);
+    
+    unsigned long long total = 0;
+    for (i = 0; i < CONSOLE_HISTOGRAM_BUCKETS; i ++)
+    {
+        total += stats.handler.buckets[i];
+    }
+    assert(total == stats.handler.count);
+    assert(ConsoleHistogram_Percentile(&stats.handler, 0.5) <= ConsoleHistogram_Percentile(&stats.handler, 0.99));
+    assert(ConsoleHistogram_Percentile(&stats.handler, 0.99) <= stats.handler.maxNanoseconds);
+    
+    assert(Console_Execute(console, "stats"));
+    assert(!Console_GetStats(console, "bogus", &stats));
+    
+    Console_ResetStats(console);
+    assert(Console_GetStats(console, "set", &stats));
+    assert(stats.calls == 0 && stats.handler.count == 0);
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+#endif
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+/* tid of the first event containing needle */
+static unsigned long long _TidInFile(FILE* file, const char* needle)
+{
+    char line[512];
+    
+    rewind(file);
+    while (fgets(line, sizeof(line), file))
+    {
+        const char* tid = strstr(line, "\"tid\":");
+        
+        if (strstr(line, needle) && tid)
+        {
+            return strtoull(tid + 6, NULL, 10);
+        }
+    }
+    
+    return 0;
+}
+#endif
+
+/* count occurrences of needle in a file */
+static int _CountInFile(FILE* file, const char* needle)
+{
+    char line[512];
+    int count = 0;
+    
+    rewind(file);
+    while (fgets(line, sizeof(line), file))
+    {
+        const char* it = line;
+        while ((it = strstr(it, needle)))
+        {
+            ++count;
+            ++it;
+        }
+    }
+    
+    return count;
+}
+
+static void _TestTrace(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    
+    /* nothing is recorded before starting */
+    Console_Execute(console, "set a 1");
+    assert(Console_StartTrace(console, 1024));
+    
+    Console_Execute(console, "set a 2");
+    Console_ExecuteScript(console, "set a 3\necho a", 15);
+    
+    FILE* saved = tmpfile();
+    Console_Save(console, saved);
+    fclose(saved);
+    
+#ifndef CONSOLE_NO_ASYNC_SAVE
+    savesDone = 0;
+    Console_SaveAsync(console, "tests.cfg", _SaveDone, NULL);
+    while (savesDone < 1)
+    {
+        Console_PollSaves(console);
+    }
+    remove("tests.cfg");
+#endif
+    
+    Console_StopTrace(console);
+    Console_Execute(console, "set a 4");
+    
+    FILE* trace = tmpfile();
+    assert(Console_WriteTrace(console, trace));
+    
+    assert(_CountInFile(trace, "\"name\":\"set\"") == 2);
+    assert(_CountInFile(trace, "\"name\":\"echo\"") == 1);
+    assert(_CountInFile(trace, "\"name\":\"script\"") == 1);
+    assert(_CountInFile(trace, "\"name\":\"Console_Save\"") == 1);
+    assert(_CountInFile(trace, "\"ph\":\"B\"") == _CountInFile(trace, "\"ph\":\"E\""));
+#ifndef CONSOLE_NO_ASYNC_SAVE
+    /* the save ran on its own thread */
+    assert(_CountInFile(trace, "\"name\":\"Console_SaveAsync\"") == 1);
+    assert(_TidInFile(trace, "\"name\":\"Console_SaveAsync\"") != _TidInFile(trace, "\"name\":\"set\""));
+#endif
+    assert(Console_TraceDropped(console) == 0);
+    fclose(trace);
+    
+    /* a full buffer drops whole spans */
+    Console_Destroy(console);
+    console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    assert(Console_StartTrace(console, 5));
+    
+    int i;
+    for (i = 0; i < 10; i ++)
+    {
+        Console_ExecuteScript(console, "set a 1", 7);
+    }
+    
+    assert(Console_Execute(console, "trace_dump \"tests_trace.json\""));
+    trace = fopen("tests_trace.json", "r");
+    assert(trace);
+    assert(_CountInFile(trace, "\"ph\":\"B\"") == 2);
+    assert(_CountInFile(trace, "\"ph\":\"E\"") == 2);
+    assert(Console_TraceDropped(console) == 19);
+    fclose(trace);
+    remove("tests_trace.json");
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
+static int bumpCount = 0;
+
+/* runs a nested command, which replay must not run twice */
+static int _Bump(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    ++bumpCount;
+    return Console_Execute(console, "set b \"bumped\"");
+}
+
+static ConsoleRef _CreateReplayConsole(FILE* log)
+{
+    ConsoleRef console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    Console_RegisterVar(console, "b", kConsoleVarTypeString, 0);
+    Console_RegisterVar(console, "c", kConsoleVarTypeDouble, 0);
+    Console_RegisterCommandArgv(console, "bump", _Bump, 0);
+    return console;
+}
+
+static void _TestReplay(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = _CreateReplayConsole(log);
+    
+    FILE* recording = fopen("tests.rec", "wb");
+    assert(Console_StartRecording(console, recording));
+    
+    int i;
+    for (i = 0; i < 100; i ++)
+    {
+        Console_Execute(console, "set a 1");
+    }
+    
+    Console_SetFrame(console, 3);
+    const char script[] = "set a 2; bump\nset b \"x y\"";
+    Console_ExecuteScript(console, script, sizeof(script) - 1);
+    
+    ConsoleCompiledRef compiled = Console_Compile(console, "set c 0.25");
+    Console_SetFrame(console, 7);
+    Console_Run(compiled);
+    
+    FILE* config = tmpfile();
+    /* a quote can't be written as a set command */
+    fputs("a : 42\nb : say\"hi\"\n", config);
+    rewind(config);
+    Console_SetFrame(console, 8);
+    assert(Console_Load(console, config));
+    fclose(config);
+    
+    assert(Console_StopRecording(console));
+    fclose(recording);
+    
+    int recordedBumps = bumpCount;
+    Console_Destroy(console);
+    
+    /* each command's text is written once, repeats are 2 bytes */
+    recording = fopen("tests.rec", "rb");
+    fseek(recording, 0, SEEK_END);
+    assert(ftell(recording) < 100 * 2 + 100);
+    fclose(recording);
+    
+    /* replay headless into a fresh console */
+    bumpCount = 0;
+    console = _CreateReplayConsole(log);
+    ConsoleReplayRef replay = ConsoleReplay_Open(console, "tests.rec");
+    assert(replay);
+    
+    unsigned int frames[8];
+    int frameCount = 0;
+    int executed = 0;
+    unsigned int frame;
+    
+    while (ConsoleReplay_NextFrame(replay, &frame))
+    {
+        assert(frameCount < 8);
+        frames[frameCount++] = frame;
+        Console_SetFrame(console, frame);
+        
+        if (frame == 3)
+        {
+            /* commands wait for their frame */
+            assert(ConsoleReplay_RunFrame(replay, 2) == 0);
+            assert(ConsoleVar_IntValue(Console_FindVar(console, "a")) == 1);
+        }
+        
+        executed += ConsoleReplay_RunFrame(replay, frame);
+    }
+    
+    assert(frameCount == 4);
+    assert(frames[0] == 0 && frames[1] == 3 && frames[2] == 7 && frames[3] == 8);
+    assert(executed == 100 + 3 + 1 + 2);
+    assert(bumpCount == recordedBumps && bumpCount == 1);
+    assert(ConsoleVar_IntValue(Console_FindVar(console, "a")) == 42);
+    assert(strcmp(ConsoleVar_StringValue(Console_FindVar(console, "b")), "say\"hi\"") == 0);
+    assert(ConsoleVar_DoubleValue(Console_FindVar(console, "c")) == 0.25);
+    
+    ConsoleReplay_Close(replay);
+    remove("tests.rec");
+    
+    assert(!ConsoleReplay_Open(console, "tests.rec"));
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
+static void _TestSnapshots(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = Console_Create(log);
+    ConsoleVarRef a = Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    ConsoleVarRef b = Console_RegisterVar(console, "b", kConsoleVarTypeString, 0);
+    ConsoleVarRef c = Console_RegisterVar(console, "c", kConsoleVarTypeDouble, 0);
+    
+    ConsoleVar_SetIntValue(a, 1);
+    ConsoleVar_SetStringValue(b, "start");
+    
+    ConsoleVarSnapshotRef first = Console_Snapshot(console);
+    assert(first);
+    
+    ConsoleVar_SetIntValue(a, 2);
+    ConsoleVar_SetIntValue(a, 3);
+    ConsoleVar_SetStringValue(b, "a string too long to be stored in the var itself");
+    
+    ConsoleVarSnapshotRef second = Console_Snapshot(console);
+    ConsoleVar_SetIntValue(a, 4);
+    ConsoleVar_SetDoubleValue(c, 0.5);
+    
+    /* restores of the newest keep older changes */
+    Console_Restore(console, second);
+    assert(ConsoleVar_IntValue(a) == 3);
+    assert(ConsoleVar_DoubleValue(c) == 0.0);
+    assert(strcmp(ConsoleVar_StringValue(b), "a string too long to be stored in the var itself") == 0);
+    
+    /* the restored snapshot can be used again */
+    ConsoleVar_SetIntValue(a, 5);
+    Console_Restore(console, second);
+    assert(ConsoleVar_IntValue(a) == 3);
+    
+    /* releasing a middle snapshot hands its values to the older one */
+    ConsoleVar_SetDoubleValue(c, 1.5);
+    ConsoleVarSnapshotRef third = Console_Snapshot(console);
+    ConsoleVar_SetIntValue(a, 6);
+    Console_ReleaseSnapshot(second);
+    ConsoleVar_SetDoubleValue(c, 2.5);
+    
+    Console_Restore(console, third);
+    assert(ConsoleVar_IntValue(a) == 3);
+    assert(ConsoleVar_DoubleValue(c) == 1.5);
+    
+    /* restoring past newer snapshots drops them */
+    ConsoleVar_SetIntValue(a, 7);
+    Console_Restore(console, first);
+    assert(ConsoleVar_IntValue(a) == 1);
+    assert(ConsoleVar_DoubleValue(c) == 0.0);
+    assert(strcmp(ConsoleVar_StringValue(b), "start") == 0);
+    
+    /* restores notify and mark changes like any set */
+    unsigned long long generation = Console_Generation(console);
+    ConsoleVar_SetIntValue(a, 8);
+    Console_Restore(console, first);
+    assert(ConsoleVar_ChangedSince(a, generation));
+    assert(!ConsoleVar_ChangedSince(b, generation));
+    
+    /* bound vars are copied when taken, so direct writes restore too */
+    int bound = 1;
+    ConsoleVarRef boundVar = Console_BindVar(console, "bound", kConsoleVarTypeInt, &bound, 0);
+    ConsoleVarSnapshotRef fourth = Console_Snapshot(console);
+    bound = 2;
+    ConsoleVar_NotifyChanged(boundVar);
+    bound = 3;
+    Console_Restore(console, fourth);
+    assert(bound == 1);
+    assert(ConsoleVar_IntValue(boundVar) == 1);
+    
+    /* freed with the console when not released */
+    Console_Snapshot(console);
+    ConsoleVar_SetStringValue(b, "left for destroy to free");
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
+static int tickCount = 0;
+
+static int _TickCount(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    ++tickCount;
+    return 1;
+}
+
+/* runs every other frame, three times */
+static int _Again(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    if (++bumpCount < 3)
+    {
+        assert(Console_ExecuteAt(console, "again", Console_Frame(console) + 2));
+    }
+    
+    return 1;
+}
+
+static void _TestSchedule(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = Console_Create(log);
+    ConsoleVarRef a = Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    ConsoleVarRef b = Console_RegisterVar(console, "b", kConsoleVarTypeString, 0);
+    Console_RegisterCommandArgv(console, "count", _TickCount, 0);
+    Console_RegisterCommandArgv(console, "again", _Again, 0);
+    ConsoleStdLib_Register(console);
+    
+    assert(Console_ExecuteAt(console, "set a 1", 5));
+    ConsoleTimerId_t cancelled = Console_ExecuteAt(console, "set a 99", 6);
+    assert(Console_Cancel(console, cancelled));
+    assert(!Console_Cancel(console, cancelled));
+    
+    assert(Console_Tick(console, 4) == 0);
+    assert(ConsoleVar_IntValue(a) == 0);
+    assert(Console_Tick(console, 5) == 1);
+    assert(ConsoleVar_IntValue(a) == 1);
+    
+    /* the rest of the script waits, wait 0 doesn't */
+    const char script[] = "set a 2; wait 3; set a 3; wait 0; set b \"waited\"";
+    Console_ExecuteScript(console, script, sizeof(script) - 1);
+    assert(ConsoleVar_IntValue(a) == 2);
+    Console_Tick(console, 7);
+    assert(ConsoleVar_IntValue(a) == 2);
+    assert(Console_Tick(console, 8) == 1);
+    assert(ConsoleVar_IntValue(a) == 3);
+    assert(strcmp(ConsoleVar_StringValue(b), "waited") == 0);
+    
+    /* far frames cascade through the levels */
+    assert(Console_ExecuteAt(console, "set a 4", 100000));
+    assert(Console_ExecuteAt(console, "set a 5", 70000));
+    Console_Tick(console, 69999);
+    assert(ConsoleVar_IntValue(a) == 3);
+    Console_Tick(console, 70000);
+    assert(ConsoleVar_IntValue(a) == 5);
+    Console_Tick(console, 100000);
+    assert(ConsoleVar_IntValue(a) == 4);
+    
+    /* frames passed go on the next tick */
+    assert(Console_ExecuteAt(console, "set a 6", 10));
+    assert(Console_Tick(console, 100000) == 0);
+    assert(Console_Tick(console, 100001) == 1);
+    assert(ConsoleVar_IntValue(a) == 6);
+    
+    /* commands can schedule themselves */
+    bumpCount = 0;
+    Console_Execute(console, "again");
+    unsigned int frame;
+    for (frame = 100002; frame < 100010; frame ++)
+    {
+        Console_Tick(console, frame);
+    }
+    assert(bumpCount == 3);
+    
+    /* many pending, half cancelled, all in a skipped range */
+    ConsoleTimerId_t ids[1000];
+    int i;
+    for (i = 0; i < 1000; i ++)
+    {
+        ids[i] = Console_ExecuteAt(console, "count", 100010 + (unsigned int)(i * 7919) % 300000);
+        assert(ids[i]);
+    }
+    
+    for (i = 0; i < 1000; i += 2)
+    {
+        assert(Console_Cancel(console, ids[i]));
+    }
+    
+    tickCount = 0;
+    assert(Console_Tick(console, 500000) == 500);
+    assert(tickCount == 500);
+    assert(Console_Frame(console) == 500000);
+    
+    /* left for destroy to free */
+    assert(Console_ExecuteAt(console, "count", 600000));
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
+static int fireCount = 0;
+
+static int _FireDown(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    ++fireCount;
+    return 1;
+}
+
+static int _FireUp(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    --fireCount;
+    return 1;
+}
+
+static ConsoleRef _CreateBindingConsole(FILE* log)
+{
+    ConsoleRef console = Console_Create(log);
+    ConsoleStdLib_Register(console);
+    Console_RegisterVar(console, "a", kConsoleVarTypeInt, 0);
+    Console_RegisterCommandArgv(console, "+fire", _FireDown, 0);
+    Console_RegisterCommandArgv(console, "-fire", _FireUp, 0);
+    Console_RegisterCommandArgv(console, "count", _TickCount, 0);
+    return console;
+}
+
+static void _TestBindings(void)
+{
+    FILE* log = tmpfile();
+    ConsoleRef console = _CreateBindingConsole(log);
+    ConsoleVarRef a = Console_FindVar(console, "a");
+    
+    tickCount = 0;
+    assert(Console_BindKey(console, 32, "count"));
+    assert(Console_KeyEvent(console, 32, 1));
+    assert(!Console_KeyEvent(console, 32, 0));
+    assert(tickCount == 1);
+    
+    /* +commands release with their - pair */
+    Console_Execute(console, "bind 70 \"+fire\"");
+    assert(Console_KeyEvent(console, 70, 1));
+    assert(fireCount == 1);
+    assert(Console_KeyEvent(console, 70, 0));
+    assert(fireCount == 0);
+    
+    /* pairs aren't limited by name length */
+    char longName[400];
+    memset(longName, 'x', sizeof(longName) - 1);
+    longName[sizeof(longName) - 1] = '\0';
+    longName[0] = '-';
+    Console_RegisterCommandArgv(console, longName, _FireUp, 0);
+    longName[0] = '+';
+    Console_RegisterCommandArgv(console, longName, _FireDown, 0);
+    assert(Console_BindKey(console, 71, longName));
+    assert(Console_KeyEvent(console, 71, 1));
+    assert(Console_KeyEvent(console, 71, 0));
+    assert(fireCount == 0);
+    Console_UnbindKey(console, 71);
+    
+    /* one character keys, more than one statement doesn't bind */
+    assert(Console_Execute(console, "bind \"a\" \"set a 3; count\""));
+    assert(!Console_KeyBinding(console, 'a'));
+    assert(!Console_BindKey(console, 'a', "set a 3; count"));
+    assert(!Console_KeyBinding(console, 'a'));
+    assert(Console_BindKey(console, 'a', "set a 3;"));
+    assert(strcmp(Console_KeyBinding(console, 'a'), "set a 3") == 0);
+    assert(Console_KeyEvent(console, 'a', 1));
+    assert(ConsoleVar_IntValue(a) == 3);
+    
+    /* bad commands keep the old binding */
+    assert(!Console_BindKey(console, 32, "missing"));
+    assert(strcmp(Console_KeyBinding(console, 32), "count") == 0);
+    assert(!Console_BindKey(console, CONSOLE_KEY_MAX, "count"));
+    assert(!Console_KeyEvent(console, 33, 1));
+    assert(!Console_KeyEvent(console, 100000, 1));
+    
+    /* re-registering rebinds on the next press */
+    Console_RegisterCommandArgv(console, "count", _FireDown, 0);
+    assert(Console_KeyEvent(console, 32, 1));
+    assert(fireCount == 1 && tickCount == 1);
+    Console_RegisterCommandArgv(console, "count", _TickCount, 0);
+    fireCount = 0;
+    
+    /* a binding may replace itself */
+    assert(Console_BindKey(console, 1, "bind 1 \"count\""));
+    assert(Console_KeyEvent(console, 1, 1));
+    assert(strcmp(Console_KeyBinding(console, 1), "count") == 0);
+    
+    Console_Execute(console, "unbind 1");
+    assert(!Console_KeyBinding(console, 1));
+    
+    /* saved with the vars */
+    FILE* config = tmpfile();
+    Console_Save(console, config);
+    rewind(config);
+    
+    Console_Destroy(console);
+    console = _CreateBindingConsole(log);
+    
+    assert(Console_Load(console, config));
+    fclose(config);
+    
+    assert(ConsoleVar_IntValue(Console_FindVar(console, "a")) == 3);
+    assert(strcmp(Console_KeyBinding(console, 32), "count") == 0);
+    assert(strcmp(Console_KeyBinding(console, 70), "+fire") == 0);
+    assert(strcmp(Console_KeyBinding(console, 'a'), "set a 3") == 0);
+    assert(!Console_KeyBinding(console, 1));
+    
+    tickCount = 0;
+    assert(Console_KeyEvent(console, 32, 1));
+    assert(tickCount == 1);
+    
+#ifndef CONSOLE_NO_ASYNC_SAVE
+    /* destroying finishes the save */
+    assert(Console_SaveAsync(console, "tests_bind.cfg", NULL, NULL));
+    Console_Destroy(console);
+    console = _CreateBindingConsole(log);
+    
+    config = fopen("tests_bind.cfg", "r");
+    assert(config && Console_Load(console, config));
+    fclose(config);
+    remove("tests_bind.cfg");
+    
+    assert(strcmp(Console_KeyBinding(console, 'a'), "set a 3") == 0);
+    assert(Console_KeyEvent(console, 70, 1));
+#endif
+    
+    Console_Destroy(console);
+    fclose(log);
+}
+
 int main(int argc, const char * argv[])
 {
+    Console_InstallAllocators(_CountingMalloc, free);
 
     ConsoleRef console = Console_Create(stdout);
     ConsoleStdLib_Register(console);
@@ -54,6 +1077,272 @@ int main(int argc, const char * argv[])
     Console_Execute(console, "set test_int test_double");
     Console_Execute(console, "echo test_int");
     
+    /* registries grow past their initial size */
+    char name[64];
+    int i;
+    for (i = 0; i < 5000; i ++)
+    {
+        sprintf(name, "grow_var_%i", i);
+        ConsoleVarRef growVar = Console_RegisterVar(console, name, kConsoleVarTypeInt, 0);
+        assert(growVar);
+    }
+    assert(Console_FindVar(console, "grow_var_0"));
+    assert(Console_FindVar(console, "grow_var_4999"));
+    int reserved = Console_Reserve(console, 10000, 1000);
+    assert(reserved);
+    assert(Console_FindVar(console, "test_int"));
+    
+    /* executing with literal arguments doesn't touch the heap */
+    int allocationsBefore = allocationCount;
+    Console_Execute(console, "set test_double 2.5");
+    Console_Execute(console, "set test_int 7");
+    Console_Execute(console, "echo \"a literal longer than the inline string buffer\"");
+    assert(allocationCount == allocationsBefore);
+    
+    /* compiled commands */
+    ConsoleCompiledRef setInt = Console_Compile(console, "set test_int 42");
+    assert(setInt);
+    allocationsBefore = allocationCount;
+    Console_Run(setInt);
+    assert(allocationCount == allocationsBefore);
+    assert(ConsoleVar_IntValue(Console_FindVar(console, "test_int")) == 42);
+    
+    /* re-registering shadows the old var, compiled commands follow */
+    ConsoleVarRef oldInt = Console_FindVar(console, "test_int");
+    ConsoleVarRef newInt = Console_RegisterVar(console, "test_int", kConsoleVarTypeInt, 0);
+    assert(Console_FindVar(console, "test_int") == newInt);
+    Console_Run(setInt);
+    assert(ConsoleVar_IntValue(newInt) == 42);
+    assert(ConsoleVar_IntValue(oldInt) == 42);
+    Console_ReleaseCompiled(setInt);
+    
+    /* one statement per handle */
+    assert(!Console_Compile(console, "set test_int 1; set test_int 2"));
+    assert(Console_Compile(console, "set test_int 1;"));
+    
+    /* vars bound to game memory */
+    double lodBias = 1.5;
+    int vsync = 0;
+    char playerName[8] = "player";
+    Console_BindVar(console, "r_lod_bias", kConsoleVarTypeDouble, &lodBias, 0);
+    Console_BindVar(console, "r_vsync", kConsoleVarTypeBool, &vsync, 0);
+    Console_BindStringVar(console, "name", playerName, sizeof(playerName), 0);
+    Console_Execute(console, "echo r_lod_bias");
+    Console_Execute(console, "set r_lod_bias 0.25");
+    Console_Execute(console, "set r_vsync TRUE");
+    Console_Execute(console, "set name \"a long player name\"");
+    assert(lodBias == 0.25);
+    assert(vsync == 1);
+    assert(strcmp(playerName, "a long ") == 0);
+    ConsoleVarRef lodBiasVar = Console_FindVar(console, "r_lod_bias");
+    unsigned long long generation = Console_Generation(console);
+    lodBias = 2.0;
+    assert(ConsoleVar_DoubleValue(lodBiasVar) == 2.0);
+    assert(!ConsoleVar_ChangedSince(lodBiasVar, generation));
+    ConsoleVar_NotifyChanged(lodBiasVar);
+    assert(ConsoleVar_ChangedSince(lodBiasVar, generation));
+    
+    /* argument arrays, and the linked list shim */
+    Console_RegisterCommandArgv(console, "avg", _Average, -1);
+    Console_RegisterCommand(console, "sum", _SumList, -1);
+    Console_Execute(console, "set test_int 6");
+    Console_Execute(console, "avg 1 2.5 test_int 4.5");
+    assert(lastAverage == 3.5);
+    Console_Execute(console, "sum 1 2.5 test_int 4.5");
+    assert(lastAverage == 14.0);
+    
+    /* number literals */
+    Console_Execute(console, "avg 0x10 -2 1e1 +0.0");
+    assert(lastAverage == 6.0);
+    assert(!Console_Execute(console, "avg 3000000000"));
+    assert(!Console_Execute(console, "avg 0x100000000"));
+    Console_Execute(console, "set test_double 0.1");
+    assert(ConsoleVar_DoubleValue(Console_FindVar(console, "test_double")) == 0.1);
+    Console_Execute(console, "set test_double 12345678901234567890.5e-3");
+    assert(ConsoleVar_DoubleValue(Console_FindVar(console, "test_double")) == 12345678901234567890.5e-3);
+    Console_Execute(console, "set test_int -2147483648");
+    assert(ConsoleVar_IntValue(Console_FindVar(console, "test_int")) == -2147483647 - 1);
+    
+    /* rounded exactly whatever the length or locale */
+    setlocale(LC_NUMERIC, "de_DE.UTF-8");
+    ConsoleVarRef testDouble = Console_FindVar(console, "test_double");
+    Console_Execute(console, "set test_double 1e-30");
+    assert(ConsoleVar_DoubleValue(testDouble) == 1e-30);
+    Console_Execute(console, "set test_double 3.14159265358979323846");
+    assert(ConsoleVar_DoubleValue(testDouble) == 3.14159265358979323846);
+    Console_Execute(console, "set test_double 0.10000000000000000555111512312578270211815834045410156250000000000000001");
+    assert(ConsoleVar_DoubleValue(testDouble) == 0.1);
+    Console_Execute(console, "set test_double 4.9406564584124654e-324");
+    assert(ConsoleVar_DoubleValue(testDouble) == 4.9406564584124654e-324);
+    Console_Execute(console, "set test_double 1.7976931348623157e308");
+    assert(ConsoleVar_DoubleValue(testDouble) == 1.7976931348623157e308);
+    assert(!Console_Execute(console, "set test_double 1.7976931348623159e308"));
+    setlocale(LC_NUMERIC, "C");
+    Console_Execute(console, "set test_int 6");
+    
+    /* typed signatures convert before dispatch and reject mismatches */
+    Console_RegisterCommandTyped(console, "spawn", _Spawn, "ifs");
+    Console_Execute(console, "spawn 2 100 \"grunt\"");
+    assert(spawnCount == 1 && spawnTeam == 2 && spawnHealth == 100.0);
+    Console_Execute(console, "spawn 3.0 test_int \"grunt\"");
+    assert(spawnCount == 2 && spawnTeam == 3 && spawnHealth == 6.0);
+    assert(!Console_Execute(console, "spawn 2.7 100 \"grunt\""));
+    assert(!Console_Execute(console, "spawn 1e10 100 \"grunt\""));
+    assert(!Console_Execute(console, "spawn test_double 100 \"grunt\""));
+    assert(!Console_Execute(console, "spawn \"red\" 100 \"grunt\""));
+    assert(!Console_Execute(console, "spawn 1 100 test_int"));
+    assert(spawnCount == 2);
+    assert(!Console_RegisterCommandTyped(console, "spawn_bad", _Spawn, "iq"));
+    assert(!Console_Execute(console, "spawn_bad 1"));
+    
+    /* change notification */
+    ConsoleVarRef gamma = Console_RegisterVar(console, "r_gamma", kConsoleVarTypeDouble, 0);
+    ConsoleVarRef fov = Console_RegisterVar(console, "r_fov", kConsoleVarTypeInt, 0);
+    ConsoleVar_SetChangeCallback(gamma, _GammaChanged, &gammaChanges);
+    
+    ConsoleVarSetRef renderVars = ConsoleVarSet_Create(console);
+    ConsoleVarSet_Add(renderVars, gamma);
+    ConsoleVarSet_Add(renderVars, fov);
+    
+    unsigned long long frameGeneration = Console_Generation(console);
+    ConsoleVarRef changed[8];
+    assert(ConsoleVarSet_Changed(renderVars, frameGeneration, changed, 8) == 0);
+    
+    Console_Execute(console, "set r_gamma 1.2");
+    Console_Execute(console, "set r_gamma 1.2");
+    Console_Execute(console, "set test_int 3");
+    assert(gammaChanges == 1);
+    assert(ConsoleVarSet_Changed(renderVars, frameGeneration, changed, 8) == 1);
+    assert(changed[0] == gamma);
+    assert(Console_ChangedVars(console, frameGeneration, changed, 8) == 2);
+    
+    frameGeneration = Console_Generation(console);
+    assert(!ConsoleVar_ChangedSince(gamma, frameGeneration));
+    ConsoleVarSet_Destroy(renderVars);
+    
+    /* doubles compare bitwise, -0.0 is a change */
+    ConsoleVar_SetDoubleValue(gamma, 0.0);
+    ConsoleVar_MarkDefault(gamma);
+    int gammaBefore = gammaChanges;
+    ConsoleVar_SetDoubleValue(gamma, -0.0);
+    assert(gammaChanges == gammaBefore + 1);
+    assert(signbit(ConsoleVar_DoubleValue(gamma)));
+    assert(ConsoleVar_Modified(gamma));
+    ConsoleVar_SetDoubleValue(gamma, 1.2);
+    
+    /* long strings move out of line */
+    Console_Execute(console, "set test_string \"a string much longer than the inline buffer\"");
+    Console_Execute(console, "echo test_string");
+    Console_Execute(console, "set test_string \"short\"");
+    Console_Execute(console, "echo test_string");
+    
+    /* binary snapshots keep strings with spaces */
+    FILE* snapshotFile = fopen("tests.snapshot", "wb");
+    assert(snapshotFile);
+    assert(Console_SaveSnapshot(console, snapshotFile));
+    fclose(snapshotFile);
+    Console_Execute(console, "set test_string \"changed\"");
+    Console_Execute(console, "set r_gamma 2.0");
+    Console_Execute(console, "set test_int 9");
+    assert(Console_LoadSnapshot(console, "tests.snapshot"));
+    assert(strcmp(ConsoleVar_StringValue(Console_FindVar(console, "test_string")), "short") == 0);
+    assert(ConsoleVar_DoubleValue(gamma) == 1.2);
+    assert(ConsoleVar_IntValue(Console_FindVar(console, "test_int")) == 3);
+    assert(!Console_ApplySnapshot(console, "not a snapshot", 14));
+    remove("tests.snapshot");
+    
+    /* defaults, and journals of only the changes */
+    Console_MarkDefaults(console);
+    assert(!ConsoleVar_Modified(gamma));
+    FILE* journal = tmpfile();
+    assert(Console_CompactJournal(console, journal));
+    assert(ftell(journal) == 0);
+    Console_Execute(console, "set r_gamma 1.8");
+    Console_Execute(console, "set r_fov 90");
+    assert(ConsoleVar_Modified(gamma));
+    assert(Console_AppendJournal(console, journal) == 2);
+    assert(Console_AppendJournal(console, journal) == 0);
+    Console_Execute(console, "set r_fov 100");
+    assert(Console_AppendJournal(console, journal) == 1);
+    assert(Console_JournalLength(console) == 3);
+    ConsoleVar_ResetToDefault(gamma);
+    ConsoleVar_ResetToDefault(fov);
+    assert(ConsoleVar_DoubleValue(gamma) == 1.2 && !ConsoleVar_Modified(fov));
+    rewind(journal);
+    assert(Console_Load(console, journal));
+    assert(ConsoleVar_DoubleValue(gamma) == 1.8);
+    assert(ConsoleVar_IntValue(fov) == 100);
+    fclose(journal);
+    
+    /* saved doubles load back bit identical */
+    ConsoleVarRef exact = Console_RegisterVar(console, "exact", kConsoleVarTypeDouble, 0);
+    ConsoleVar_SetDoubleValue(exact, 0.1 + 0.2);
+    FILE* exactFile = tmpfile();
+    Console_SaveModified(console, exactFile);
+    ConsoleVar_SetDoubleValue(exact, 0.0);
+    rewind(exactFile);
+    assert(Console_Load(console, exactFile));
+    assert(ConsoleVar_DoubleValue(exact) == 0.1 + 0.2);
+    fclose(exactFile);
+    
+    char number[CONSOLE_NUMBER_STRING_MAX];
+    Console_FormatDouble(0.3, number);
+    assert(strcmp(number, "0.3") == 0);
+    Console_FormatDouble(-1e21, number);
+    assert(strcmp(number, "-1e21") == 0);
+    Console_FormatDouble(5e-324, number);
+    assert(strtod(number, NULL) == 5e-324);
+    Console_FormatInt(-2147483647 - 1, number);
+    assert(strcmp(number, "-2147483648") == 0);
+    
+#ifndef CONSOLE_NO_ASYNC_SAVE
+    /* background saves finish in order, values are copied up front */
+    Console_SaveAsync(console, "tests.cfg", _SaveDone, NULL);
+    Console_Execute(console, "set r_fov 110");
+    Console_SaveAsync(console, "tests.cfg", _SaveDone, NULL);
+    Console_Execute(console, "set r_fov 120");
+    while (savesDone < 2)
+    {
+        Console_PollSaves(console);
+    }
+    FILE* saved = fopen("tests.cfg", "r");
+    assert(saved);
+    char line[256];
+    int foundFov = 0;
+    while (fgets(line, sizeof(line), saved))
+    {
+        foundFov |= strcmp(line, "r_fov : 110\n") == 0;
+    }
+    fclose(saved);
+    assert(foundFov);
+    remove("tests.cfg");
+#endif
+    
+    _TestScripts();
+    _TestNames();
+    _TestTrace();
+    _TestReplay();
+    _TestSnapshots();
+    _TestSchedule();
+    _TestBindings();
+#ifdef CONSOLE_PROFILE
+    _TestStats();
+#endif
+    
+#ifndef CONSOLE_NO_THREADS
+    _TestQueue(console);
+    _TestConcurrentReads(console);
+    _TestLogRing(console);
+#endif
+    
+    ConsoleMemoryStats_t stats;
+    Console_MemoryStats(console, &stats);
+    printf("%i vars, %i var bytes, %i name bytes, %i total bytes\n",
+           (int)stats.varCount,
+           (int)stats.varBytes,
+           (int)stats.nameBytes,
+           (int)stats.totalBytes);
+    
     Console_Destroy(console);
     
     return 0;
@@ -6,656 +6,7758 @@
  Licensed under the MIT license: http://www.opensource.org/licenses/mit-license.php
  */
 
+/* clock_gettime, and syscall for thread ids on Linux */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "Console.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
+#include <time.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <math.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* thread ids for traces */
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+/* bit scans for dirty var words */
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#ifndef CONSOLE_NO_THREADS
+#include <stdatomic.h>
+#include <limits.h>
+#endif
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+#include <pthread.h>
+#endif
 
 
-#define CONSOLE_MAX_COMMANDS 128
-#define CONSOLE_MAX_VARS 1024
 #define CONSOLE_VAR_NAME_MAX 256
 #define CONSOLE_VAR_STRING_MAX 1024
 
 #define CONSOLE_MAX_TOKENS 128
 
+/* initial slot count of the symbol indices, must be a power of 2 */
+#define CONSOLE_INDEX_MIN_CAPACITY 64
+
+/* initial size of the var and command registries */
+#define CONSOLE_REGISTRY_MIN_CAPACITY 32
+
+/* strings shorter than this are stored inside the var */
+#define CONSOLE_VAR_STRING_LOCAL 16
+
+/* size of the blocks names are interned into */
+#define CONSOLE_POOL_CHUNK_SIZE 4096
+
+/* size of the blocks temporary execution data is carved from */
+#define CONSOLE_ARENA_CHUNK_SIZE 8192
+/* compiled commands are small, each owns an arena of these */
+#define CONSOLE_COMPILED_CHUNK_SIZE 256
+#define CONSOLE_ARENA_ALIGN 16
+
+/* pending commands from other threads, must be a power of 2 */
+#define CONSOLE_QUEUE_CAPACITY 256
+
+/* Console_Printf output longer than this is allocated */
+#define CONSOLE_PRINT_BUFFER_SIZE 512
+
+/* longer trace event names are cut */
+#define CONSOLE_TRACE_NAME_MAX 40
+
+/* line records per byte of log ring text */
+#define CONSOLE_LOG_RING_LINE_BYTES 32
+
+/* commands recorded are written out in blocks of this size */
+#define CONSOLE_RECORD_BUFFER_SIZE (64 * 1024)
+#define CONSOLE_RECORD_VERSION 2
+/*
+ starts a recorded string var assignment, "\1name\0value\0", for
+ values a set command can't quote. version 1 files have none
+ */
+#define CONSOLE_RECORD_SET_STRING '\1'
+
+/* scheduled commands, levels of slots covering 8 bits of frame each */
+#define CONSOLE_TIMER_LEVELS 4
+#define CONSOLE_TIMER_SLOT_BITS 8
+#define CONSOLE_TIMER_SLOTS (1 << CONSOLE_TIMER_SLOT_BITS)
+/* list of timers being run, after the slots */
+#define CONSOLE_TIMER_FIRING (CONSOLE_TIMER_LEVELS * CONSOLE_TIMER_SLOTS)
+
+/* 'CVSB' read as a little endian word, byte swapped files don't match */
+#define CONSOLE_SNAPSHOT_MAGIC 0x42535643u
+#define CONSOLE_SNAPSHOT_VERSION 1
+
 static void *(*_Console_Malloc)(size_t sz) = malloc;
 static void (*_Console_Free)(void *ptr) = free;
 
 
-struct ConsoleVar
+/* bits kept in ConsoleVar.internal */
+enum
+{
+    /* argument literal, owned by the executor */
+    kConsoleVarInternalTemp = 1 << 0,
+    /* string value lives in value.heap instead of value.local */
+    kConsoleVarInternalHeapString = 1 << 1,
+    /* value lives in game memory at value.bound */
+    kConsoleVarInternalBound = 1 << 2,
+    /* numbers are atomics, strings live in value.shared */
+    kConsoleVarInternalConcurrent = 1 << 3,
+};
+
+#ifndef CONSOLE_NO_THREADS
+/*
+ string storage of concurrent vars.
+ the console thread keeps a plain copy it can hand out directly and
+ publishes each value to readers under a sequence lock.
+ */
+struct ConsoleSharedString
+{
+    /* odd while a write is in progress */
+    atomic_uint sequence;
+    char owner[CONSOLE_VAR_CONCURRENT_STRING_MAX];
+    atomic_char published[CONSOLE_VAR_CONCURRENT_STRING_MAX];
+};
+#endif
+
+/* value a var was registered with, or last marked as default */
+union ConsoleVarDefault
 {
-    char name[CONSOLE_VAR_NAME_MAX];
-    struct ConsoleVal;
-    ConsoleVarType_t type;
     int intValue;
     double doubleValue;
-    char stringValue[CONSOLE_VAR_STRING_MAX];
-    ConsoleVarFlag_t flags;
-    int temp;
+    /* heap copy, NULL for an empty string */
+    char* stringValue;
+};
+
+struct ConsoleVarListener
+{
+    ConsoleVarCallback_t callback;
+    void* context;
+};
+
+struct ConsoleVar
+{
+    /* interned in the console string pool */
+    const char* name;
+    unsigned int hash;
+    /* registry position */
+    unsigned int index;
+    unsigned char type;
+    unsigned char internal;
+    unsigned short flags;
+    
+    /* owner, NULL for literals */
+    struct Console* console;
+    
+    /* console generation of the last change */
+    unsigned long long generation;
+    
+    /* rarely used, kept out of line */
+    struct ConsoleVarListener* listener;
+    
+    union
+    {
+        int intValue;
+        double doubleValue;
+        char local[CONSOLE_VAR_STRING_LOCAL];
+        struct
+        {
+            char* data;
+            size_t capacity;
+        } heap;
+        struct
+        {
+            void* data;
+            /* bytes, strings only */
+            size_t capacity;
+        } bound;
+#ifndef CONSOLE_NO_THREADS
+        _Atomic int atomicInt;
+        _Atomic double atomicDouble;
+        struct ConsoleSharedString* shared;
+#endif
+    } value;
 };
 
 struct ConsoleCommand
 {
-    char name[CONSOLE_VAR_NAME_MAX];
+    const char* name;
+    unsigned int hash;
     int argCount;
+    /* one of these is set */
     ConsoleFunc_t func;
+    ConsoleArgvFunc_t argvFunc;
+    /* argument types of typed argv commands, NULL otherwise */
+    char* signature;
+#ifdef CONSOLE_PROFILE
+    ConsoleCommandStats_t stats;
+#endif
+};
+
+/*
+ open addressing hash table mapping names to vars or commands.
+ slots cache the name hash so probing rarely touches the names.
+ */
+struct ConsoleIndexSlot
+{
+    const char* name;
+    unsigned int hash;
+    void* item;
+};
+
+struct ConsoleIndex
+{
+    struct ConsoleIndexSlot* slots;
+    unsigned int capacity;
+    unsigned int count;
+};
+
+struct ConsolePoolChunk
+{
+    struct ConsolePoolChunk* next;
+    size_t size;
+    size_t used;
+    /* string data follows */
+};
+
+/*
+ bump allocator for data that only lives during Console_Execute.
+ chunks are kept after a reset so steady state execution never
+ touches the heap.
+ */
+struct ConsoleArenaChunk
+{
+    struct ConsoleArenaChunk* next;
+    size_t size;
+    size_t used;
+    /* aligned data follows */
+};
+
+struct ConsoleArena
+{
+    struct ConsoleArenaChunk* first;
+    struct ConsoleArenaChunk* current;
+    size_t chunkSize;
+};
+
+struct ConsoleArenaMark
+{
+    struct ConsoleArenaChunk* chunk;
+    size_t used;
+};
+
+/* a command resolved against the console, ready to dispatch */
+struct ConsoleStatement
+{
+    ConsoleCommandRef command;
+    int argCount;
+    /* literal values, or the var to load at dispatch */
+    ConsoleArgView_t* views;
+    /* linked list version for ConsoleFunc_t commands, NULL otherwise */
+    ConsoleArgRef args;
+    /* console symbolGeneration the statement was resolved at */
+    unsigned int generation;
+};
+
+/* a token inside command text, not terminated */
+struct ConsoleToken
+{
+    const char* text;
+    size_t length;
+};
+
+/* splits command text into statements */
+struct ConsoleLexer
+{
+    /* script name for errors, NULL for single commands */
+    const char* name;
+    const char* it;
+    const char* end;
+    int line;
+    /* line the last statement started on */
+    int statementLine;
+};
+
+struct ConsoleCompiled
+{
+    ConsoleRef console;
+    struct ConsoleCompiled* prev;
+    struct ConsoleCompiled* next;
+    /* owns the statement and its literals */
+    struct ConsoleArena arena;
+    struct ConsoleStatement statement;
+    /* the statement text, for recording */
+    const char* source;
+    size_t sourceLength;
+};
+
+#ifndef CONSOLE_NO_THREADS
+/*
+ bounded multi producer, single consumer ring.
+ each slot's sequence tells producers and the consumer
+ whose turn it is, so neither side takes a lock.
+ */
+struct ConsoleQueueSlot
+{
+    atomic_size_t sequence;
+    char command[CONSOLE_QUEUE_COMMAND_MAX];
+};
+
+struct ConsoleQueue
+{
+    struct ConsoleQueueSlot* slots;
+    /* next slot producers claim */
+    atomic_size_t tail;
+    /* next slot the console thread reads, consumer only */
+    size_t head;
+};
+
+/*
+ single writer ring of output lines. positions are absolute byte
+ offsets that only increase, masked into data. each line is kept
+ contiguous so readers get a pointer instead of a copy.
+ a reader publishes the oldest line it uses in pin, and the writer
+ drops new output rather than evict a pinned line.
+ */
+struct ConsoleLogRingLine
+{
+    unsigned long long start;
+    size_t length;
+};
+
+struct ConsoleLogRing
+{
+    char* data;
+    size_t capacity;
+    struct ConsoleLogRingLine* lines;
+    size_t lineCapacity;
+    
+    /* oldest readable line */
+    atomic_ullong first;
+    /* one past the newest published line */
+    atomic_ullong tail;
+    /* oldest line held by the reader, ULLONG_MAX when not reading */
+    atomic_ullong pin;
+    atomic_ullong dropped;
+    
+    /* line being written, writer only */
+    unsigned long long openStart;
+    size_t openLength;
+    int dropping;
+};
+#endif
+
+/*
+ binary snapshot layout, in the byte order of the machine that wrote it:
+ the header, an entry per var, a value per var, then the names and
+ string values. offsets are from the start of the file.
+ */
+struct ConsoleSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t varCount;
+    uint32_t entriesOffset;
+    uint32_t valuesOffset;
+    /* whole file */
+    uint32_t size;
+};
+
+struct ConsoleSnapshotEntry
+{
+    /* console name hash, so loading doesn't rehash names */
+    uint32_t hash;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t type;
+};
+
+union ConsoleSnapshotValue
+{
+    double doubleValue;
+    int64_t intValue;
+    struct
+    {
+        uint32_t offset;
+        uint32_t length;
+    } string;
+};
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+/* a var value copied for a background save */
+struct ConsoleSaveEntry
+{
+    /* interned, lives as long as the console */
+    const char* name;
+    /* strings point into the job's string block */
+    ConsoleArgView_t view;
+};
+
+/*
+ saves run one at a time in submission order, so an older
+ save can never replace a newer file
+ */
+struct ConsoleSaveJob
+{
+    struct ConsoleSaveJob* next;
+    
+    /* path, temp file and directory, in one block */
+    char* path;
+    char* tempPath;
+    char* directory;
+    
+    struct ConsoleSaveEntry* entries;
+    int entryCount;
+    char* strings;
+    
+    ConsoleSaveCallback_t callback;
+    void* context;
+    
+    pthread_t thread;
+    int started;
+    /* set by the worker after success is written */
+    atomic_int done;
+    int success;
+    
+    /* the console's trace when the job was created */
+    struct ConsoleTrace* trace;
+};
+#endif
+
+/*
+ trace events are recorded into a buffer per thread, so threads
+ never share a write position. buffers are pushed onto a list
+ the first time a thread records and live until the console does.
+ */
+struct ConsoleTraceEvent
+{
+    long long time;
+    char phase;
+    char name[CONSOLE_TRACE_NAME_MAX];
+};
+
+struct ConsoleTraceBuffer
+{
+    struct ConsoleTraceBuffer* next;
+    /* identifies the owning thread */
+    const void* thread;
+    /* the OS thread id, or a counter where there is none */
+    unsigned long long tid;
+    /* begun events whose end still needs a slot, owner only */
+    int open;
+#ifndef CONSOLE_NO_THREADS
+    /* written by the owner, read by Console_WriteTrace */
+    atomic_int count;
+    atomic_int dropped;
+#else
+    int count;
+    int dropped;
+#endif
+    struct ConsoleTraceEvent events[];
+};
+
+struct ConsoleTrace
+{
+    /* distinguishes traces for thread caches */
+    unsigned long long id;
+    int capacity;
+#ifndef CONSOLE_NO_THREADS
+    _Atomic(struct ConsoleTraceBuffer*) buffers;
+    atomic_int enabled;
+    atomic_ullong nextTid;
+#else
+    struct ConsoleTraceBuffer* buffers;
+    int enabled;
+    unsigned long long nextTid;
+#endif
+};
+
+struct ConsoleVarSet
+{
+    ConsoleRef console;
+    /* var index bits, same layout as the console dirty bits */
+    unsigned long long* bits;
+    int wordCount;
+};
+
+/*
+ command recording, a header followed by records of
+ varint frame delta, varint string id and, the first time
+ an id appears, varint length and the command text.
+ the text may instead be a CONSOLE_RECORD_SET_STRING assignment
+ */
+struct ConsoleRecorder
+{
+    FILE* file;
+    unsigned char* buffer;
+    size_t used;
+    int failed;
+    
+    /* each distinct command is written once */
+    struct ConsoleIndex strings;
+    struct ConsoleArena stringArena;
+    unsigned int stringCount;
+    
+    unsigned int lastFrame;
+};
+
+struct ConsoleTimer
+{
+    char* command;
+    size_t length;
+    unsigned int frame;
+    /* half of the id, stale ids don't match */
+    unsigned int serial;
+    
+    /* links by index within the list, -1 ends */
+    int prev;
+    int next;
+    /* slot or firing list, -1 once free */
+    int list;
+    
+    /* scheduled by a running command, which replay runs again */
+    int nested;
+};
+
+/*
+ hierarchical timer wheel. a timer sits in the level of the highest
+ 8 bits where its frame differs from nextFrame, so each slot holds
+ timers sharing all higher bits. as frames reach the start of a slot's
+ span its timers cascade down a level, level 0 slots run by frame
+ */
+struct ConsoleTimerWheel
+{
+    struct ConsoleTimer* timers;
+    int timerCount;
+    int timerCapacity;
+    int freeTimer;
+    int pendingCount;
+    
+    /* earliest frame not yet run */
+    unsigned int nextFrame;
+    unsigned int serial;
+    int ticking;
+    
+    int heads[CONSOLE_TIMER_FIRING + 1];
+};
+
+/*
+ a key's command, compiled when bound so presses skip parsing.
+ commands named +name run -name on release
+ */
+struct ConsoleKeyBinding
+{
+    /* the statement as bound, for saving */
+    char* command;
+    ConsoleCompiledRef down;
+    ConsoleCompiledRef up;
+};
+
+struct ConsoleReplaySpan
+{
+    const char* text;
+    size_t length;
+};
+
+struct ConsoleReplay
+{
+    ConsoleRef console;
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    
+    /* commands by string id */
+    struct ConsoleReplaySpan* strings;
+    int stringCount;
+    int stringCapacity;
+    
+    /* the record at offset, valid while pending */
+    int pending;
+    unsigned int frame;
+    unsigned int id;
+};
+
+/*
+ var values as they were at a console generation. the first change
+ of each var after the newest snapshot copies the old value into it,
+ so taking one is O(1) and restoring is O(vars changed since)
+ */
+struct ConsoleVarSnapshotChange
+{
+    ConsoleVarRef var;
+    union ConsoleVarDefault value;
+};
+
+struct ConsoleVarSnapshot
+{
+    ConsoleRef console;
+    unsigned long long generation;
+    struct ConsoleVarSnapshotChange* changes;
+    int changeCount;
+    int changeCapacity;
+    /* released but its changes couldn't be handed to the older one */
+    int released;
+    struct ConsoleVarSnapshot* older;
+    struct ConsoleVarSnapshot* newer;
+};
+
+struct ConsoleName
+{
+    const char* name;
+    /* ConsoleSymbol_t bits registered under this name */
+    unsigned int symbols;
 };
 
 struct Console
 {
-    ConsoleCommandRef commands[CONSOLE_MAX_COMMANDS];
+    ConsoleCommandRef* commands;
     int commandCount;
+    int commandCapacity;
+    struct ConsoleIndex commandIndex;
     
-    ConsoleVarRef vars[CONSOLE_MAX_VARS];
+    ConsoleVarRef* vars;
     int varCount;
+    int varCapacity;
+    struct ConsoleIndex varIndex;
+    
+    /* by var index */
+    union ConsoleVarDefault* defaults;
+    int defaultCapacity;
+    
+    /* var and command names */
+    struct ConsolePoolChunk* namePool;
+    
+    /*
+     every distinct name in strcmp order, for prefix queries.
+     registrations append and are merged in by the next query
+     */
+    struct ConsoleName* names;
+    int nameCount;
+    int nameCapacity;
+    int sortedNameCount;
+    
+    /* argument literals of executing commands */
+    struct ConsoleArena arena;
+    
+    /* bumped when a registration shadows an existing name */
+    unsigned int symbolGeneration;
+    
+    /* bumped by every var change */
+    unsigned long long generation;
+    /*
+     bit per var index set once it has changed, and the
+     latest generation of any change per 64 var word
+     */
+    unsigned long long* dirtyBits;
+    unsigned long long* dirtyGenerations;
+    int dirtyWordCapacity;
+    
+    /* generation written by the last journal append or compaction */
+    unsigned long long journalGeneration;
+    /* entries appended since the last compaction */
+    int journalLength;
+    
+    struct ConsoleCompiled* compiled;
+    
+#ifndef CONSOLE_NO_THREADS
+    struct ConsoleQueue queue;
+#endif
+    
+#ifndef CONSOLE_NO_ASYNC_SAVE
+    /* the first is running, the rest wait their turn */
+    struct ConsoleSaveJob* saves;
+    struct ConsoleSaveJob* lastSave;
+#endif
+    
+    /* where Console_Write goes, the log file by default */
+    ConsoleOutputFunc_t outputFunc;
+    void* outputContext;
+    
+    /* script being executed, for error positions */
+    const char* scriptName;
+    int scriptLine;
+    
+    /* NULL until Console_StartTrace */
+    struct ConsoleTrace* trace;
+    
+    /* copy on write var snapshots, NULL when there are none */
+    struct ConsoleVarSnapshot* newestSnapshot;
+    
+    /* writes to game memory can't be seen, so snapshots copy these when taken */
+    ConsoleVarRef* boundVars;
+    int boundVarCount;
+    int boundVarCapacity;
+    
+    /* NULL unless recording */
+    struct ConsoleRecorder* recorder;
+    unsigned int frame;
+    /* command functions running, only the outermost commands are recorded */
+    int executeDepth;
+    
+    /* by key code, grown to the highest bound key */
+    struct ConsoleKeyBinding* bindings;
+    int bindingCount;
+    int bindingCapacity;
+    
+    /* NULL until a command is scheduled */
+    struct ConsoleTimerWheel* timers;
+    /* frames the executing script asked to wait */
+    int waitFrames;
+    
+#ifdef CONSOLE_PROFILE
+    /* when lexing of the executing statement began */
+    long long parseStart;
+#endif
     
     FILE* logFile;
 };
 
-static ConsoleVarRef _ConsoleVar_Create(ConsoleVarType_t type, int temporary)
+#ifndef CONSOLE_NO_ASYNC_SAVE
+static void _Console_FinishSaves(ConsoleRef console);
+#endif
+static void _Console_WriteLogFile(const char* text, size_t length, void* context);
+static void _Console_Record(ConsoleRef console, const char* text, size_t length);
+static void _Console_RecordVar(ConsoleRef console, ConsoleVarRef var);
+static int _Console_RunScript(ConsoleRef console, const char* name, const char* script, size_t length);
+static void _ConsoleVarSnapshot_Preserve(struct ConsoleVarSnapshot* snapshot, ConsoleVarRef var);
+static void _ConsoleVarSnapshot_Destroy(struct ConsoleVarSnapshot* snapshot);
+static ConsoleTimerId_t _Console_Schedule(ConsoleRef console, const char* command, size_t length, unsigned int frame);
+static void _ConsoleTimerWheel_Destroy(struct ConsoleTimerWheel* wheel);
+static void _Console_VPrintf(ConsoleRef console, const char* format, va_list args);
+
+#define CONSOLE_ARENA_CHUNK_HEADER ((sizeof(struct ConsoleArenaChunk) + CONSOLE_ARENA_ALIGN - 1) & ~(size_t)(CONSOLE_ARENA_ALIGN - 1))
+
+static struct ConsoleArenaChunk* _ConsoleArena_CreateChunk(size_t size)
 {
-    ConsoleVarRef var = _Console_Malloc(sizeof(struct ConsoleVar));
+    struct ConsoleArenaChunk* chunk = _Console_Malloc(CONSOLE_ARENA_CHUNK_HEADER + size);
     
-    if (var)
+    if (chunk)
     {
-        var->intValue = 0;
-        var->doubleValue = 0.0;
-        var->type = type;
-        var->flags = 0;
-        var->temp = temporary;
+        chunk->next = NULL;
+        chunk->size = size;
+        chunk->used = 0;
     }
     
-    return var;
+    return chunk;
 }
 
-void Console_InstallAllocators(void *(*mallocFunc)(size_t sz), void (*freeFunc)(void *ptr))
+/* returns success */
+static int _ConsoleArena_Init(struct ConsoleArena* arena, size_t chunkSize)
 {
-    _Console_Malloc = mallocFunc;
-    _Console_Free = freeFunc;
+    arena->chunkSize = chunkSize;
+    arena->first = _ConsoleArena_CreateChunk(chunkSize);
+    arena->current = arena->first;
+    return arena->first != NULL;
 }
 
-ConsoleVarType_t ConsoleVar_Type(ConsoleVarRef var)
+static void _ConsoleArena_Shutdown(struct ConsoleArena* arena)
 {
-    assert(var);
-    return var->type;
+    struct ConsoleArenaChunk* chunk = arena->first;
+    
+    while (chunk)
+    {
+        struct ConsoleArenaChunk* next = chunk->next;
+        _Console_Free(chunk);
+        chunk = next;
+    }
+    
+    arena->first = NULL;
+    arena->current = NULL;
 }
 
-extern int ConsoleVar_Readonly(ConsoleVarRef var)
+static void* _ConsoleArena_Alloc(struct ConsoleArena* arena, size_t size)
 {
-    assert(var);
-    return var->flags & kConsoleVarFlagReadonly;
+    size = (size + CONSOLE_ARENA_ALIGN - 1) & ~(size_t)(CONSOLE_ARENA_ALIGN - 1);
+    
+    struct ConsoleArenaChunk* chunk = arena->current;
+    
+    while (chunk->size - chunk->used < size)
+    {
+        /* reuse chunks left over from earlier executions */
+        if (chunk->next && chunk->next->size >= size)
+        {
+            chunk = chunk->next;
+            chunk->used = 0;
+        }
+        else
+        {
+            struct ConsoleArenaChunk* newChunk = _ConsoleArena_CreateChunk(size > arena->chunkSize ? size : arena->chunkSize);
+            
+            if (!newChunk)
+            {
+                return NULL;
+            }
+            
+            newChunk->next = chunk->next;
+            chunk->next = newChunk;
+            chunk = newChunk;
+        }
+    }
+    
+    arena->current = chunk;
+    
+    void* memory = (char*)chunk + CONSOLE_ARENA_CHUNK_HEADER + chunk->used;
+    chunk->used += size;
+    return memory;
 }
 
-extern void ConsoleVar_SetDoubleValue(ConsoleVarRef var, double value)
+static struct ConsoleArenaMark _ConsoleArena_Mark(const struct ConsoleArena* arena)
 {
-    assert(var);
-    assert(var->type == kConsoleVarTypeDouble);
-    var->doubleValue = value;
-    var->intValue = (int)value;
+    struct ConsoleArenaMark mark;
+    mark.chunk = arena->current;
+    mark.used = arena->current->used;
+    return mark;
 }
 
-double ConsoleVar_DoubleValue(ConsoleVarRef var)
+/* release everything allocated since mark */
+static void _ConsoleArena_Reset(struct ConsoleArena* arena, struct ConsoleArenaMark mark)
 {
-    assert(var);
+    arena->current = mark.chunk;
+    arena->current->used = mark.used;
+}
+
+/* monotonic clock in nanoseconds */
+static long long _Console_Now(void)
+{
+    struct timespec now;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+    timespec_get(&now, TIME_UTC);
+#endif
+    return (long long)now.tv_sec * 1000000000LL + (long long)now.tv_nsec;
+}
+
+#ifndef CONSOLE_NO_THREADS
+static atomic_ullong _Console_TraceIds = 1;
+
+/* the buffer this thread last used, and an address unique to the thread */
+static _Thread_local unsigned long long _Console_TraceCacheId;
+static _Thread_local struct ConsoleTraceBuffer* _Console_TraceCacheBuffer;
+static _Thread_local char _Console_TraceThread;
+#endif
+
+/*
+ the calling thread's OS id, so console events share tracks
+ with other traces of the process - returns 0 where there is none
+ */
+static unsigned long long _Console_ThreadId(void)
+{
+#if defined(_WIN32)
+    return (unsigned long long)GetCurrentThreadId();
+#elif defined(__APPLE__)
+    uint64_t tid = 0;
+    pthread_threadid_np(NULL, &tid);
+    return (unsigned long long)tid;
+#elif defined(__linux__)
+    return (unsigned long long)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+static struct ConsoleTraceBuffer* _ConsoleTrace_CreateBuffer(struct ConsoleTrace* trace, const void* thread, unsigned long long tid)
+{
+    struct ConsoleTraceBuffer* buffer = _Console_Malloc(sizeof(struct ConsoleTraceBuffer) +
+                                                        sizeof(struct ConsoleTraceEvent) * (size_t)trace->capacity);
+    
+    if (!buffer)
+    {
+        return NULL;
+    }
+    
+    buffer->thread = thread;
+    buffer->open = 0;
+    
+#ifndef CONSOLE_NO_THREADS
+    buffer->tid = tid ? tid : atomic_fetch_add_explicit(&trace->nextTid, 1, memory_order_relaxed);
+    atomic_init(&buffer->count, 0);
+    atomic_init(&buffer->dropped, 0);
+    
+    buffer->next = atomic_load_explicit(&trace->buffers, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&trace->buffers, &buffer->next, buffer,
+                                                  memory_order_release, memory_order_relaxed))
+    {
+    }
+#else
+    buffer->tid = tid ? tid : trace->nextTid++;
+    buffer->count = 0;
+    buffer->dropped = 0;
+    buffer->next = trace->buffers;
+    trace->buffers = buffer;
+#endif
+    
+    return buffer;
+}
+
+/* the calling thread's buffer, created on first use - returns NULL if out of memory */
+static struct ConsoleTraceBuffer* _ConsoleTrace_Buffer(struct ConsoleTrace* trace)
+{
+#ifndef CONSOLE_NO_THREADS
+    if (_Console_TraceCacheId == trace->id)
+    {
+        return _Console_TraceCacheBuffer;
+    }
+    
+    const void* thread = &_Console_TraceThread;
+    unsigned long long tid = _Console_ThreadId();
+    struct ConsoleTraceBuffer* buffer = atomic_load_explicit(&trace->buffers, memory_order_acquire);
+    
+    /* a thread that exited may leave its address to a new one, the id tells them apart */
+    while (buffer && (buffer->thread != thread || (tid && buffer->tid != tid)))
+    {
+        buffer = buffer->next;
+    }
+    
+    if (!buffer)
+    {
+        buffer = _ConsoleTrace_CreateBuffer(trace, thread, tid);
+        
+        if (!buffer)
+        {
+            return NULL;
+        }
+    }
+    
+    _Console_TraceCacheId = trace->id;
+    _Console_TraceCacheBuffer = buffer;
+    return buffer;
+#else
+    return trace->buffers ? trace->buffers : _ConsoleTrace_CreateBuffer(trace, trace, _Console_ThreadId());
+#endif
+}
+
+static void _ConsoleTrace_Record(struct ConsoleTraceBuffer* buffer, int count, char phase, const char* name, size_t length)
+{
+    struct ConsoleTraceEvent* event = buffer->events + count;
+    event->time = _Console_Now();
+    event->phase = phase;
+    
+    if (length >= CONSOLE_TRACE_NAME_MAX)
+    {
+        length = CONSOLE_TRACE_NAME_MAX - 1;
+    }
+    
+    memcpy(event->name, name, length);
+    event->name[length] = '\0';
+    
+#ifndef CONSOLE_NO_THREADS
+    atomic_store_explicit(&buffer->count, count + 1, memory_order_release);
+#else
+    buffer->count = count + 1;
+#endif
+}
+
+/*
+ record the start of a span. a begin is only recorded when its end
+ is sure to fit - returns whether the matching _ConsoleTrace_End
+ should record
+ */
+static int _ConsoleTrace_Begin(struct ConsoleTrace* trace, const char* name, size_t length)
+{
+    if (!trace)
+    {
+        return 0;
+    }
+    
+#ifndef CONSOLE_NO_THREADS
+    if (!atomic_load_explicit(&trace->enabled, memory_order_relaxed))
+    {
+        return 0;
+    }
+#else
+    if (!trace->enabled)
+    {
+        return 0;
+    }
+#endif
+    
+    struct ConsoleTraceBuffer* buffer = _ConsoleTrace_Buffer(trace);
+    
+    if (!buffer)
+    {
+        return 0;
+    }
+    
+#ifndef CONSOLE_NO_THREADS
+    int count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+#else
+    int count = buffer->count;
+#endif
+    
+    if (count + buffer->open + 2 > trace->capacity)
+    {
+#ifndef CONSOLE_NO_THREADS
+        atomic_fetch_add_explicit(&buffer->dropped, 1, memory_order_relaxed);
+#else
+        buffer->dropped++;
+#endif
+        return 0;
+    }
+    
+    buffer->open++;
+    _ConsoleTrace_Record(buffer, count, 'B', name, length);
+    return 1;
+}
+
+static void _ConsoleTrace_End(struct ConsoleTrace* trace, int begun)
+{
+    if (!begun)
+    {
+        return;
+    }
+    
+    struct ConsoleTraceBuffer* buffer = _ConsoleTrace_Buffer(trace);
+    
+#ifndef CONSOLE_NO_THREADS
+    int count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+#else
+    int count = buffer->count;
+#endif
+    
+    buffer->open--;
+    _ConsoleTrace_Record(buffer, count, 'E', "", 0);
+}
+
+static int _Console_TraceBegin(ConsoleRef console, const char* name)
+{
+    return console->trace && _ConsoleTrace_Begin(console->trace, name, strlen(name));
+}
+
+static void _Console_TraceEnd(ConsoleRef console, int begun)
+{
+    _ConsoleTrace_End(console->trace, begun);
+}
+
+static void _ConsoleTrace_Destroy(struct ConsoleTrace* trace)
+{
+    if (!trace)
+    {
+        return;
+    }
+    
+#ifndef CONSOLE_NO_THREADS
+    struct ConsoleTraceBuffer* buffer = atomic_load_explicit(&trace->buffers, memory_order_acquire);
+#else
+    struct ConsoleTraceBuffer* buffer = trace->buffers;
+#endif
+    
+    while (buffer)
+    {
+        struct ConsoleTraceBuffer* next = buffer->next;
+        _Console_Free(buffer);
+        buffer = next;
+    }
+    
+    _Console_Free(trace);
+}
+
+#ifdef CONSOLE_PROFILE
+static void _ConsoleHistogram_Add(ConsoleHistogram_t* histogram, long long nanoseconds)
+{
+    unsigned long long value = nanoseconds > 0 ? (unsigned long long)nanoseconds : 0;
+    
+    /* floor(log2(value)) in a few steps */
+    unsigned long long rest = value;
+    int bucket = 0;
+    
+    if (rest >> 32) { rest >>= 32; bucket += 32; }
+    if (rest >> 16) { rest >>= 16; bucket += 16; }
+    if (rest >> 8) { rest >>= 8; bucket += 8; }
+    if (rest >> 4) { rest >>= 4; bucket += 4; }
+    if (rest >> 2) { rest >>= 2; bucket += 2; }
+    if (rest >> 1) { bucket += 1; }
+    
+    if (bucket >= CONSOLE_HISTOGRAM_BUCKETS)
+    {
+        bucket = CONSOLE_HISTOGRAM_BUCKETS - 1;
+    }
+    
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->totalNanoseconds += value;
+    
+    if (value > histogram->maxNanoseconds)
+    {
+        histogram->maxNanoseconds = value;
+    }
+}
+
+unsigned long long ConsoleHistogram_Percentile(const ConsoleHistogram_t* histogram, double fraction)
+{
+    assert(histogram);
+    
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+    
+    unsigned long long rank = (unsigned long long)(fraction * (double)histogram->count);
+    unsigned long long seen = 0;
+    
+    int i;
+    for (i = 0; i < CONSOLE_HISTOGRAM_BUCKETS; i ++)
+    {
+        seen += histogram->buckets[i];
+        
+        if (seen > rank)
+        {
+            break;
+        }
+    }
+    
+    if (i >= CONSOLE_HISTOGRAM_BUCKETS - 1)
+    {
+        return histogram->maxNanoseconds;
+    }
+    
+    /* top of the bucket, but never more than was seen */
+    unsigned long long bound = (2ULL << i) - 1;
+    return bound < histogram->maxNanoseconds ? bound : histogram->maxNanoseconds;
+}
+#endif
+
+#ifndef CONSOLE_NO_THREADS
+/* returns success */
+static int _ConsoleQueue_Init(struct ConsoleQueue* queue)
+{
+    queue->slots = _Console_Malloc(sizeof(struct ConsoleQueueSlot) * CONSOLE_QUEUE_CAPACITY);
+    
+    if (!queue->slots)
+    {
+        return 0;
+    }
+    
+    size_t i;
+    for (i = 0; i < CONSOLE_QUEUE_CAPACITY; i ++)
+    {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    
+    atomic_init(&queue->tail, 0);
+    queue->head = 0;
+    return 1;
+}
+
+static void _ConsoleQueue_Shutdown(struct ConsoleQueue* queue)
+{
+    _Console_Free(queue->slots);
+    queue->slots = NULL;
+}
+#endif
+
+/* FNV-1a */
+static unsigned int _Console_Hash(const char* name)
+{
+    unsigned int hash = 2166136261u;
+    
+    while (*name)
+    {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+        name++;
+    }
+    
+    return hash;
+}
+
+static unsigned int _Console_HashToken(struct ConsoleToken token)
+{
+    unsigned int hash = 2166136261u;
+    
+    size_t i;
+    for (i = 0; i < token.length; i ++)
+    {
+        hash ^= (unsigned char)token.text[i];
+        hash *= 16777619u;
+    }
+    
+    return hash;
+}
+
+static void _ConsoleIndex_Init(struct ConsoleIndex* index)
+{
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+static void _ConsoleIndex_Shutdown(struct ConsoleIndex* index)
+{
+    _Console_Free(index->slots);
+    _ConsoleIndex_Init(index);
+}
+
+static void* _ConsoleIndex_Find(const struct ConsoleIndex* index, const char* name, unsigned int hash)
+{
+    if (index->capacity == 0)
+    {
+        return NULL;
+    }
+    
+    unsigned int mask = index->capacity - 1;
+    unsigned int i = hash & mask;
+    
+    while (index->slots[i].item)
+    {
+        if (index->slots[i].hash == hash && strcmp(index->slots[i].name, name) == 0)
+        {
+            return index->slots[i].item;
+        }
+        
+        i = (i + 1) & mask;
+    }
+    
+    return NULL;
+}
+
+/* _ConsoleIndex_Find for a name that isn't terminated */
+static void* _ConsoleIndex_FindToken(const struct ConsoleIndex* index, struct ConsoleToken token, unsigned int hash)
+{
+    if (index->capacity == 0)
+    {
+        return NULL;
+    }
+    
+    unsigned int mask = index->capacity - 1;
+    unsigned int i = hash & mask;
+    
+    while (index->slots[i].item)
+    {
+        const char* name = index->slots[i].name;
+        
+        if (index->slots[i].hash == hash &&
+            strncmp(name, token.text, token.length) == 0 &&
+            name[token.length] == '\0')
+        {
+            return index->slots[i].item;
+        }
+        
+        i = (i + 1) & mask;
+    }
+    
+    return NULL;
+}
+
+static void _ConsoleIndex_Place(struct ConsoleIndex* index, const char* name, unsigned int hash, void* item)
+{
+    unsigned int mask = index->capacity - 1;
+    unsigned int i = hash & mask;
+    
+    while (index->slots[i].item)
+    {
+        i = (i + 1) & mask;
+    }
+    
+    index->slots[i].name = name;
+    index->slots[i].hash = hash;
+    index->slots[i].item = item;
+    index->count++;
+}
+
+/* returns success */
+static int _ConsoleIndex_Resize(struct ConsoleIndex* index, unsigned int newCapacity)
+{
+    struct ConsoleIndexSlot* newSlots = _Console_Malloc(sizeof(struct ConsoleIndexSlot) * newCapacity);
+    
+    if (!newSlots)
+    {
+        return 0;
+    }
+    
+    memset(newSlots, 0, sizeof(struct ConsoleIndexSlot) * newCapacity);
+    
+    struct ConsoleIndex old = *index;
+    index->slots = newSlots;
+    index->capacity = newCapacity;
+    index->count = 0;
+    
+    unsigned int i;
+    for (i = 0; i < old.capacity; i ++)
+    {
+        if (old.slots[i].item)
+        {
+            _ConsoleIndex_Place(index, old.slots[i].name, old.slots[i].hash, old.slots[i].item);
+        }
+    }
+    
+    _Console_Free(old.slots);
+    return 1;
+}
+
+/* make room for count entries without rehashing, returns success */
+static int _ConsoleIndex_Reserve(struct ConsoleIndex* index, unsigned int count)
+{
+    unsigned int capacity = index->capacity ? index->capacity : CONSOLE_INDEX_MIN_CAPACITY;
+    
+    /* keep load factor under 1/2 */
+    while (count * 2 > capacity)
+    {
+        capacity *= 2;
+    }
+    
+    if (capacity == index->capacity)
+    {
+        return 1;
+    }
+    
+    return _ConsoleIndex_Resize(index, capacity);
+}
+
+/*
+ the latest registration of a name wins.
+ returns the item it replaced, or NULL
+ */
+static void* _ConsoleIndex_Insert(struct ConsoleIndex* index, const char* name, unsigned int hash, void* item)
+{
+    unsigned int mask = index->capacity - 1;
+    unsigned int i = hash & mask;
+    
+    if (index->capacity)
+    {
+        while (index->slots[i].item)
+        {
+            if (index->slots[i].hash == hash && strcmp(index->slots[i].name, name) == 0)
+            {
+                void* replaced = index->slots[i].item;
+                index->slots[i].item = item;
+                return replaced;
+            }
+            
+            i = (i + 1) & mask;
+        }
+    }
+    
+    /* registries reserve the index before inserting */
+    assert((index->count + 1) * 2 <= index->capacity);
+    _ConsoleIndex_Place(index, name, hash, item);
+    return NULL;
+}
+
+/*
+ grows an array to hold at least count items, returning the
+ (possibly moved) array or NULL if out of memory.
+ capacity doubles so appends are amortized O(1).
+ */
+static void* _Console_ReserveArray(void* items, size_t itemSize, int itemCount, int* capacity, int count)
+{
+    if (count <= *capacity)
+    {
+        return items;
+    }
+    
+    int newCapacity = *capacity ? *capacity : CONSOLE_REGISTRY_MIN_CAPACITY;
+    while (newCapacity < count)
+    {
+        newCapacity *= 2;
+    }
+    
+    void* newItems = _Console_Malloc(itemSize * newCapacity);
+    
+    if (!newItems)
+    {
+        return NULL;
+    }
+    
+    if (items)
+    {
+        memcpy(newItems, items, itemSize * itemCount);
+        _Console_Free(items);
+    }
+    
+    *capacity = newCapacity;
+    return newItems;
+}
+
+/* zero filled growth of a word array, returns the new array or NULL */
+static unsigned long long* _Console_GrowWords(unsigned long long* words, int wordCount, int newWordCount)
+{
+    unsigned long long* newWords = _Console_Malloc(sizeof(unsigned long long) * newWordCount);
+    
+    if (!newWords)
+    {
+        return NULL;
+    }
+    
+    memset(newWords, 0, sizeof(unsigned long long) * newWordCount);
+    
+    if (words)
+    {
+        memcpy(newWords, words, sizeof(unsigned long long) * wordCount);
+        _Console_Free(words);
+    }
+    
+    return newWords;
+}
+
+static int _Console_ReserveDirty(ConsoleRef console, int count)
+{
+    int wordCount = (count + 63) / 64;
+    
+    if (wordCount <= console->dirtyWordCapacity)
+    {
+        return 1;
+    }
+    
+    /* grow with the registry so this rarely runs */
+    wordCount = (console->varCapacity + 63) / 64;
+    
+    unsigned long long* bits = _Console_GrowWords(console->dirtyBits, console->dirtyWordCapacity, wordCount);
+    
+    if (!bits)
+    {
+        return 0;
+    }
+    
+    console->dirtyBits = bits;
+    
+    unsigned long long* generations = _Console_GrowWords(console->dirtyGenerations, console->dirtyWordCapacity, wordCount);
+    
+    if (!generations)
+    {
+        return 0;
+    }
+    
+    console->dirtyGenerations = generations;
+    console->dirtyWordCapacity = wordCount;
+    return 1;
+}
+
+static int _Console_ReserveNames(ConsoleRef console, int count)
+{
+    struct ConsoleName* names = _Console_ReserveArray(console->names, sizeof(struct ConsoleName), console->nameCount, &console->nameCapacity, count);
+    
+    if (!names)
+    {
+        return 0;
+    }
+    
+    console->names = names;
+    return 1;
+}
+
+/* first name not ordered before prefix, comparing only prefix length characters */
+static int _Console_LowerName(ConsoleRef console, const char* prefix, size_t length)
+{
+    int low = 0;
+    int high = console->nameCount;
+    
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        
+        if (strncmp(console->names[middle].name, prefix, length) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+/* registries reserve space first so this can't fail */
+static void _Console_AddName(ConsoleRef console, const char* name, unsigned int symbol)
+{
+    assert(console->nameCount < console->nameCapacity);
+    
+    console->names[console->nameCount].name = name;
+    console->names[console->nameCount].symbols = symbol;
+    console->nameCount++;
+}
+
+static int _ConsoleName_Compare(const void* a, const void* b)
+{
+    return strcmp(((const struct ConsoleName*)a)->name, ((const struct ConsoleName*)b)->name);
+}
+
+/*
+ sort names appended since the last query and merge them in.
+ costs O(n + k log k) once after k registrations, so registering
+ many symbols at startup doesn't pay for a sorted insert each
+ */
+static void _Console_SortNames(ConsoleRef console)
+{
+    int sorted = console->sortedNameCount;
+    int added = console->nameCount - sorted;
+    
+    if (added == 0)
+    {
+        return;
+    }
+    
+    struct ConsoleName* names = console->names;
+    qsort(names + sorted, (size_t)added, sizeof(struct ConsoleName), _ConsoleName_Compare);
+    
+    struct ConsoleName* tail = sorted ? _Console_Malloc(sizeof(struct ConsoleName) * (size_t)added) : NULL;
+    
+    if (tail)
+    {
+        /* merge from the back so the sorted names move at most once */
+        memcpy(tail, names + sorted, sizeof(struct ConsoleName) * (size_t)added);
+        
+        int i = sorted - 1;
+        int j = added - 1;
+        int out = console->nameCount - 1;
+        
+        while (j >= 0)
+        {
+            if (i >= 0 && strcmp(names[i].name, tail[j].name) > 0)
+            {
+                names[out--] = names[i--];
+            }
+            else
+            {
+                names[out--] = tail[j--];
+            }
+        }
+        
+        _Console_Free(tail);
+    }
+    else if (sorted)
+    {
+        /* out of memory, sort everything in place */
+        qsort(names, (size_t)console->nameCount, sizeof(struct ConsoleName), _ConsoleName_Compare);
+    }
+    
+    /* interned names are shared, so equal names are equal pointers */
+    int count = 0;
+    int i;
+    for (i = 0; i < console->nameCount; i ++)
+    {
+        if (count > 0 && names[count - 1].name == names[i].name)
+        {
+            names[count - 1].symbols |= names[i].symbols;
+        }
+        else
+        {
+            names[count++] = names[i];
+        }
+    }
+    
+    console->nameCount = count;
+    console->sortedNameCount = count;
+}
+
+static int _Console_ReserveVars(ConsoleRef console, int count)
+{
+    ConsoleVarRef* vars = _Console_ReserveArray(console->vars, sizeof(ConsoleVarRef), console->varCount, &console->varCapacity, count);
+    
+    if (!vars)
+    {
+        return 0;
+    }
+    
+    console->vars = vars;
+    
+    union ConsoleVarDefault* defaults = _Console_ReserveArray(console->defaults, sizeof(union ConsoleVarDefault), console->varCount, &console->defaultCapacity, count);
+    
+    if (!defaults)
+    {
+        return 0;
+    }
+    
+    console->defaults = defaults;
+    return _ConsoleIndex_Reserve(&console->varIndex, (unsigned int)count) &&
+           _Console_ReserveDirty(console, count) &&
+           _Console_ReserveNames(console, count + console->commandCount);
+}
+
+static int _Console_ReserveCommands(ConsoleRef console, int count)
+{
+    ConsoleCommandRef* commands = _Console_ReserveArray(console->commands, sizeof(ConsoleCommandRef), console->commandCount, &console->commandCapacity, count);
+    
+    if (!commands)
+    {
+        return 0;
+    }
+    
+    console->commands = commands;
+    return _ConsoleIndex_Reserve(&console->commandIndex, (unsigned int)count) &&
+           _Console_ReserveNames(console, console->varCount + count);
+}
+
+/* copy a name into the pool, sharing it when a var or command already uses it */
+static const char* _Console_InternName(ConsoleRef console, const char* name, unsigned int hash)
+{
+    const char* existing = NULL;
+    
+    ConsoleVarRef var = _ConsoleIndex_Find(&console->varIndex, name, hash);
+    if (var)
+    {
+        existing = var->name;
+    }
+    else
+    {
+        ConsoleCommandRef command = _ConsoleIndex_Find(&console->commandIndex, name, hash);
+        if (command)
+        {
+            existing = command->name;
+        }
+    }
+    
+    if (existing)
+    {
+        return existing;
+    }
+    
+    size_t length = strlen(name) + 1;
+    struct ConsolePoolChunk* chunk = console->namePool;
+    
+    if (!chunk || chunk->size - chunk->used < length)
+    {
+        size_t size = length > CONSOLE_POOL_CHUNK_SIZE ? length : CONSOLE_POOL_CHUNK_SIZE;
+        chunk = _Console_Malloc(sizeof(struct ConsolePoolChunk) + size);
+        
+        if (!chunk)
+        {
+            return NULL;
+        }
+        
+        chunk->next = console->namePool;
+        chunk->size = size;
+        chunk->used = 0;
+        console->namePool = chunk;
+    }
+    
+    char* interned = (char*)(chunk + 1) + chunk->used;
+    memcpy(interned, name, length);
+    chunk->used += length;
+    
+    return interned;
+}
+
+static ConsoleVarRef _ConsoleVar_Create(ConsoleVarType_t type)
+{
+    ConsoleVarRef var = _Console_Malloc(sizeof(struct ConsoleVar));
+    
+    if (var)
+    {
+        var->name = "";
+        var->hash = 0;
+        var->type = (unsigned char)type;
+        var->flags = 0;
+        var->internal = 0;
+        var->console = NULL;
+        var->index = 0;
+        var->generation = 0;
+        var->listener = NULL;
+        
+        if (type == kConsoleVarTypeString)
+        {
+            var->value.local[0] = '\0';
+        }
+        else if (type == kConsoleVarTypeDouble)
+        {
+            var->value.doubleValue = 0.0;
+        }
+        else
+        {
+            var->value.intValue = 0;
+        }
+    }
+    
+    return var;
+}
+
+/* readonly argument literal, released with its arena */
+static ConsoleVarRef _Console_CreateTempVar(struct ConsoleArena* arena, ConsoleVarType_t type)
+{
+    ConsoleVarRef var = _ConsoleArena_Alloc(arena, sizeof(struct ConsoleVar));
+    
+    if (var)
+    {
+        var->name = "";
+        var->hash = 0;
+        var->type = (unsigned char)type;
+        var->flags = kConsoleVarFlagReadonly;
+        var->internal = kConsoleVarInternalTemp;
+        var->console = NULL;
+        var->index = 0;
+        var->generation = 0;
+        var->listener = NULL;
+        var->value.doubleValue = 0.0;
+    }
+    
+    return var;
+}
+
+static ConsoleVarRef _Console_CreateTempString(struct ConsoleArena* arena, const char* string)
+{
+    ConsoleVarRef var = _Console_CreateTempVar(arena, kConsoleVarTypeString);
+    size_t length = strlen(string) + 1;
+    
+    if (!var)
+    {
+        return NULL;
+    }
+    
+    if (length <= CONSOLE_VAR_STRING_LOCAL)
+    {
+        memcpy(var->value.local, string, length);
+    }
+    else
+    {
+        char* data = _ConsoleArena_Alloc(arena, length);
+        
+        if (!data)
+        {
+            return NULL;
+        }
+        
+        memcpy(data, string, length);
+        
+        /* arena owned, never freed by _ConsoleVar_Destroy */
+        var->value.heap.data = data;
+        var->value.heap.capacity = length;
+        var->internal |= kConsoleVarInternalHeapString;
+    }
+    
+    return var;
+}
+
+static void _ConsoleVar_Destroy(ConsoleVarRef var)
+{
+    _Console_Free(var->listener);
+    
+    if (var->internal & kConsoleVarInternalHeapString)
+    {
+        _Console_Free(var->value.heap.data);
+    }
+    
+#ifndef CONSOLE_NO_THREADS
+    if ((var->internal & kConsoleVarInternalConcurrent) && var->type == kConsoleVarTypeString)
+    {
+        _Console_Free(var->value.shared);
+    }
+#endif
+    
+    _Console_Free(var);
+}
+
+void Console_InstallAllocators(void *(*mallocFunc)(size_t sz), void (*freeFunc)(void *ptr))
+{
+    _Console_Malloc = mallocFunc;
+    _Console_Free = freeFunc;
+}
+
+ConsoleVarType_t ConsoleVar_Type(ConsoleVarRef var)
+{
+    assert(var);
+    return var->type;
+}
+
+extern int ConsoleVar_Readonly(ConsoleVarRef var)
+{
+    assert(var);
+    return var->flags & kConsoleVarFlagReadonly;
+}
+
+const char* ConsoleVar_Name(ConsoleVarRef var)
+{
+    assert(var);
+    return var->name;
+}
+
+/* storage of numeric values, inside the var or bound game memory */
+static double* _ConsoleVar_DoubleStorage(ConsoleVarRef var)
+{
+    if (var->internal & kConsoleVarInternalBound)
+    {
+        return var->value.bound.data;
+    }
+    
+    return &var->value.doubleValue;
+}
+
+static int* _ConsoleVar_IntStorage(ConsoleVarRef var)
+{
+    if (var->internal & kConsoleVarInternalBound)
+    {
+        return var->value.bound.data;
+    }
+    
+    return &var->value.intValue;
+}
+
+#ifndef CONSOLE_NO_THREADS
+/* returns success */
+static int _ConsoleVar_MakeConcurrent(ConsoleVarRef var)
+{
+    if (var->type == kConsoleVarTypeString)
+    {
+        struct ConsoleSharedString* shared = _Console_Malloc(sizeof(struct ConsoleSharedString));
+        
+        if (!shared)
+        {
+            return 0;
+        }
+        
+        atomic_init(&shared->sequence, 0);
+        shared->owner[0] = '\0';
+        atomic_init(&shared->published[0], '\0');
+        
+        var->value.shared = shared;
+    }
+    else if (var->type == kConsoleVarTypeDouble)
+    {
+        atomic_init(&var->value.atomicDouble, 0.0);
+    }
+    else
+    {
+        atomic_init(&var->value.atomicInt, 0);
+    }
+    
+    var->internal |= kConsoleVarInternalConcurrent;
+    return 1;
+}
+
+/* single writer, the console thread */
+static void _ConsoleVar_PublishString(struct ConsoleSharedString* shared, const char* string)
+{
+    size_t length = strlen(string);
+    
+    if (length > CONSOLE_VAR_CONCURRENT_STRING_MAX - 1)
+    {
+        length = CONSOLE_VAR_CONCURRENT_STRING_MAX - 1;
+    }
+    
+    memcpy(shared->owner, string, length);
+    shared->owner[length] = '\0';
+    
+    unsigned int sequence = atomic_load_explicit(&shared->sequence, memory_order_relaxed);
+    atomic_store_explicit(&shared->sequence, sequence + 1, memory_order_relaxed);
+    
+    /*
+     release orders the odd sequence before each byte, so a reader
+     that sees any new byte also sees the write in progress
+     */
+    size_t i;
+    for (i = 0; i <= length; i ++)
+    {
+        atomic_store_explicit(&shared->published[i], shared->owner[i], memory_order_release);
+    }
+    
+    atomic_store_explicit(&shared->sequence, sequence + 2, memory_order_release);
+}
+
+/* any thread, retries while the console thread is writing */
+static void _ConsoleVar_ReadString(struct ConsoleSharedString* shared, char* buffer, size_t bufferSize)
+{
+    for (;;)
+    {
+        unsigned int before = atomic_load_explicit(&shared->sequence, memory_order_acquire);
+        
+        if (before & 1)
+        {
+            continue;
+        }
+        
+        size_t i;
+        for (i = 0; i + 1 < bufferSize; i ++)
+        {
+            buffer[i] = atomic_load_explicit(&shared->published[i], memory_order_acquire);
+            
+            if (buffer[i] == '\0')
+            {
+                break;
+            }
+        }
+        buffer[i] = '\0';
+        
+        if (atomic_load_explicit(&shared->sequence, memory_order_relaxed) == before)
+        {
+            return;
+        }
+    }
+}
+#endif
+
+static void _ConsoleVar_WriteDouble(ConsoleVarRef var, double value)
+{
+#ifndef CONSOLE_NO_THREADS
+    if (var->internal & kConsoleVarInternalConcurrent)
+    {
+        atomic_store_explicit(&var->value.atomicDouble, value, memory_order_release);
+        return;
+    }
+#endif
+    
+    *_ConsoleVar_DoubleStorage(var) = value;
+}
+
+double ConsoleVar_DoubleValue(ConsoleVarRef var)
+{
+    assert(var);
+    
+#ifndef CONSOLE_NO_THREADS
+    if (var->internal & kConsoleVarInternalConcurrent)
+    {
+        switch (var->type)
+        {
+            case kConsoleVarTypeDouble:
+                return atomic_load_explicit(&var->value.atomicDouble, memory_order_acquire);
+            case kConsoleVarTypeInt:
+            case kConsoleVarTypeBool:
+                return (double)atomic_load_explicit(&var->value.atomicInt, memory_order_acquire);
+            case kConsoleVarTypeString:
+            {
+                char buffer[CONSOLE_VAR_CONCURRENT_STRING_MAX];
+                double val = 0.0;
+                _ConsoleVar_ReadString(var->value.shared, buffer, sizeof(buffer));
+                sscanf(buffer, "%lf", &val);
+                return val;
+            }
+            default:
+                break;
+        }
+    }
+#endif
+    
+    switch (var->type)
+    {
+        case kConsoleVarTypeDouble:
+            return *_ConsoleVar_DoubleStorage(var);
+        case kConsoleVarTypeInt:
+            return (double)*_ConsoleVar_IntStorage(var);
+        case kConsoleVarTypeBool:
+            return (double)*_ConsoleVar_IntStorage(var);
+        case kConsoleVarTypeString:
+        {
+            double val = 0.0;
+            sscanf(ConsoleVar_StringValue(var), "%lf", &val);
+            return val;
+        }
+        default:
+            break;
+    }
+    
+    return 0.0;
+}
+
+static void _ConsoleVar_WriteInt(ConsoleVarRef var, int value)
+{
+#ifndef CONSOLE_NO_THREADS
+    if (var->internal & kConsoleVarInternalConcurrent)
+    {
+        atomic_store_explicit(&var->value.atomicInt, value, memory_order_release);
+        return;
+    }
+#endif
+    
+    *_ConsoleVar_IntStorage(var) = value;
+}
+
+int ConsoleVar_IntValue(ConsoleVarRef var)
+{
+    assert(var);
+    
+#ifndef CONSOLE_NO_THREADS
+    if (var->internal & kConsoleVarInternalConcurrent)
+    {
+        switch (var->type)
+        {
+            case kConsoleVarTypeDouble:
+                return (int)atomic_load_explicit(&var->value.atomicDouble, memory_order_acquire);
+            case kConsoleVarTypeInt:
+            case kConsoleVarTypeBool:
+                return atomic_load_explicit(&var->value.atomicInt, memory_order_acquire);
+            case kConsoleVarTypeString:
+            {
+                char buffer[CONSOLE_VAR_CONCURRENT_STRING_MAX];
+                int val = 0;
+                _ConsoleVar_ReadString(var->value.shared, buffer, sizeof(buffer));
+                sscanf(buffer, "%d", &val);
+                return val;
+            }
+            default:
+                break;
+        }
+    }
+#endif
+    
+    switch (var->type)
+    {
+        case kConsoleVarTypeDouble:
+            return (int)*_ConsoleVar_DoubleStorage(var);
+        case kConsoleVarTypeInt:
+            return *_ConsoleVar_IntStorage(var);
+        case kConsoleVarTypeBool:
+            return *_ConsoleVar_IntStorage(var);
+        case kConsoleVarTypeString:
+        {
+            int val = 0;
+            sscanf(ConsoleVar_StringValue(var), "%d", &val);
+            return val;
+        }
+        default:
+            break;
+    }
+    
+    return 0;
+}
+
+int ConsoleVar_BoolValue(ConsoleVarRef var)
+{
+    return ConsoleVar_IntValue(var);
+}
+
+static void _ConsoleVar_WriteString(ConsoleVarRef var, const char* string)
+{
+    size_t length = strlen(string) + 1;
+    
+#ifndef CONSOLE_NO_THREADS
+    if (var->internal & kConsoleVarInternalConcurrent)
+    {
+        _ConsoleVar_PublishString(var->value.shared, string);
+        return;
+    }
+#endif
+    
+    if (var->internal & kConsoleVarInternalBound)
+    {
+        /* game buffers can't grow, truncate */
+        char* data = var->value.bound.data;
+        size_t copy = length <= var->value.bound.capacity ? length - 1 : var->value.bound.capacity - 1;
+        
+        memcpy(data, string, copy);
+        data[copy] = '\0';
+        return;
+    }
+    
+    if (var->internal & kConsoleVarInternalHeapString)
+    {
+        if (length <= var->value.heap.capacity)
+        {
+            memcpy(var->value.heap.data, string, length);
+            return;
+        }
+    }
+    else if (length <= CONSOLE_VAR_STRING_LOCAL)
+    {
+        memcpy(var->value.local, string, length);
+        return;
+    }
+    
+    /* doesn't fit, move to a larger heap buffer */
+    size_t capacity = CONSOLE_VAR_STRING_LOCAL * 2;
+    while (capacity < length)
+    {
+        capacity *= 2;
+    }
+    
+    char* data = _Console_Malloc(capacity);
+    
+    if (!data)
+    {
+        return;
+    }
+    
+    memcpy(data, string, length);
+    
+    if (var->internal & kConsoleVarInternalHeapString)
+    {
+        _Console_Free(var->value.heap.data);
+    }
+    
+    var->value.heap.data = data;
+    var->value.heap.capacity = capacity;
+    var->internal |= kConsoleVarInternalHeapString;
+}
+
+const char* ConsoleVar_StringValue(ConsoleVarRef var)
+{
+    assert(var);
+    
+    if (var->type != kConsoleVarTypeString)
+    {
+        return "";
+    }
+    
+#ifndef CONSOLE_NO_THREADS
+    if (var->internal & kConsoleVarInternalConcurrent)
+    {
+        return var->value.shared->owner;
+    }
+#endif
+    
+    if (var->internal & kConsoleVarInternalBound)
+    {
+        return var->value.bound.data;
+    }
+    
+    if (var->internal & kConsoleVarInternalHeapString)
+    {
+        return var->value.heap.data;
+    }
+    
+    return var->value.local;
+}
+
+void ConsoleVar_CopyStringValue(ConsoleVarRef var, char* buffer, size_t bufferSize)
+{
+    assert(var);
+    assert(buffer);
+    assert(bufferSize > 0);
+    
+#ifndef CONSOLE_NO_THREADS
+    if ((var->internal & kConsoleVarInternalConcurrent) && var->type == kConsoleVarTypeString)
+    {
+        _ConsoleVar_ReadString(var->value.shared, buffer, bufferSize);
+        return;
+    }
+#endif
+    
+    const char* string = ConsoleVar_StringValue(var);
+    size_t length = strlen(string);
+    
+    if (length > bufferSize - 1)
+    {
+        length = bufferSize - 1;
+    }
+    
+    memcpy(buffer, string, length);
+    buffer[length] = '\0';
+}
+
+/* copy on write, called before a registered var's value changes. bound vars were copied up front */
+static void _ConsoleVar_WillChange(ConsoleVarRef var)
+{
+    ConsoleRef console = var->console;
+    
+    if (console && console->newestSnapshot && var->generation <= console->newestSnapshot->generation &&
+        !(var->internal & kConsoleVarInternalBound))
+    {
+        _ConsoleVarSnapshot_Preserve(console->newestSnapshot, var);
+    }
+}
+
+/* record a change of a registered var and notify its listener */
+static void _ConsoleVar_Changed(ConsoleVarRef var)
+{
+    ConsoleRef console = var->console;
+    
+    if (!console)
+    {
+        return;
+    }
+    
+    unsigned long long generation = ++console->generation;
+    unsigned int word = var->index / 64;
+    
+    var->generation = generation;
+    console->dirtyBits[word] |= (unsigned long long)1 << (var->index % 64);
+    console->dirtyGenerations[word] = generation;
+    
+    if (var->listener)
+    {
+        var->listener->callback(var, var->listener->context);
+    }
+}
+
+/* bitwise, so -0.0 differs from 0.0 and a NaN matches only itself */
+static int _Console_SameDouble(double a, double b)
+{
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+void ConsoleVar_SetDoubleValue(ConsoleVarRef var, double value)
+{
+    assert(var);
+    assert(var->type == kConsoleVarTypeDouble);
+    
+    if (_Console_SameDouble(ConsoleVar_DoubleValue(var), value))
+    {
+        return;
+    }
+    
+    _ConsoleVar_WillChange(var);
+    _ConsoleVar_WriteDouble(var, value);
+    _ConsoleVar_Changed(var);
+}
+
+void ConsoleVar_SetIntValue(ConsoleVarRef var, int value)
+{
+    assert(var);
+    assert(var->type == kConsoleVarTypeInt ||
+           var->type == kConsoleVarTypeBool);
+    
+    if (ConsoleVar_IntValue(var) == value)
+    {
+        return;
+    }
+    
+    _ConsoleVar_WillChange(var);
+    _ConsoleVar_WriteInt(var, value);
+    _ConsoleVar_Changed(var);
+}
+
+void ConsoleVar_SetBoolValue(ConsoleVarRef var, int value)
+{
+    ConsoleVar_SetIntValue(var, value);
+}
+
+void ConsoleVar_SetStringValue(ConsoleVarRef var, const char* string)
+{
+    assert(var);
+    assert(var->type == kConsoleVarTypeString);
+    assert(string);
+    
+    if (strcmp(ConsoleVar_StringValue(var), string) == 0)
+    {
+        return;
+    }
+    
+    _ConsoleVar_WillChange(var);
+    _ConsoleVar_WriteString(var, string);
+    _ConsoleVar_Changed(var);
+}
+
+void ConsoleVar_NotifyChanged(ConsoleVarRef var)
+{
+    assert(var);
+    _ConsoleVar_Changed(var);
+}
+
+void ConsoleVar_SetChangeCallback(ConsoleVarRef var, ConsoleVarCallback_t callback, void* context)
+{
+    assert(var);
+    
+    if (!callback)
+    {
+        _Console_Free(var->listener);
+        var->listener = NULL;
+        return;
+    }
+    
+    if (!var->listener)
+    {
+        var->listener = _Console_Malloc(sizeof(struct ConsoleVarListener));
+        
+        if (!var->listener)
+        {
+            return;
+        }
+    }
+    
+    var->listener->callback = callback;
+    var->listener->context = context;
+}
+
+int ConsoleVar_ChangedSince(ConsoleVarRef var, unsigned long long generation)
+{
+    assert(var);
+    return var->generation > generation;
+}
+
+double ConsoleArgView_DoubleValue(const ConsoleArgView_t* view)
+{
+    assert(view);
+    
+    switch (view->type)
+    {
+        case kConsoleVarTypeDouble:
+            return view->value.doubleValue;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            return (double)view->value.intValue;
+        case kConsoleVarTypeString:
+        {
+            double val = 0.0;
+            sscanf(view->value.stringValue, "%lf", &val);
+            return val;
+        }
+        default:
+            break;
+    }
+    
+    return 0.0;
+}
+
+int ConsoleArgView_IntValue(const ConsoleArgView_t* view)
+{
+    assert(view);
+    
+    switch (view->type)
+    {
+        case kConsoleVarTypeDouble:
+            return (int)view->value.doubleValue;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            return view->value.intValue;
+        case kConsoleVarTypeString:
+        {
+            int val = 0;
+            sscanf(view->value.stringValue, "%d", &val);
+            return val;
+        }
+        default:
+            break;
+    }
+    
+    return 0;
+}
+
+const char* ConsoleArgView_StringValue(const ConsoleArgView_t* view)
+{
+    assert(view);
+    
+    if (view->type != kConsoleVarTypeString)
+    {
+        return "";
+    }
+    
+    return view->value.stringValue;
+}
+
+/* read the current value of a var argument into its view */
+static void _ConsoleArgView_Load(ConsoleArgView_t* view)
+{
+    ConsoleVarRef var = view->var;
+    
+    view->type = (ConsoleVarType_t)var->type;
+    
+    switch (var->type)
+    {
+        case kConsoleVarTypeDouble:
+            view->value.doubleValue = ConsoleVar_DoubleValue(var);
+            break;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            view->value.intValue = ConsoleVar_IntValue(var);
+            break;
+        case kConsoleVarTypeString:
+            view->value.stringValue = ConsoleVar_StringValue(var);
+            break;
+        default:
+            break;
+    }
+}
+
+static void _ConsoleCommand_Destroy(ConsoleCommandRef command)
+{
+    _Console_Free(command->signature);
+    _Console_Free(command);
+}
+
+static ConsoleCommandRef _ConsoleCommand_Create()
+{
+    ConsoleCommandRef command = _Console_Malloc(sizeof(struct ConsoleCommand));
+    
+    if (command)
+    {
+        command->name = "";
+        command->hash = 0;
+        command->func = NULL;
+        command->argvFunc = NULL;
+        command->signature = NULL;
+        command->argCount = -1;
+#ifdef CONSOLE_PROFILE
+        memset(&command->stats, 0, sizeof(ConsoleCommandStats_t));
+        command->stats.name = "";
+#endif
+    }
+    
+    return command;
+}
+
+/* lists all available commands, sorted */
+static int _Console_Help(ConsoleRef console, ConsoleArgRef args)
+{
+    Console_Printf(console, "%i commands available\n", console->commandCount);
+    
+    _Console_SortNames(console);
+    
+    int i;
+    for (i = 0; i < console->nameCount; i ++)
+    {
+        if (console->names[i].symbols & kConsoleSymbolCommand)
+        {
+            Console_Printf(console, "%s ", console->names[i].name);
+        }
+    }
+    
+    Console_Write(console, "\n", 1);
+    
+    return 1;
+}
+
+/* write recorded trace events as JSON */
+static int _Console_TraceDump(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    if (argv[0].type != kConsoleVarTypeString || argv[0].var)
+    {
+        return 0;
+    }
+    
+    FILE* file = fopen(argv[0].value.stringValue, "w");
+    
+    if (!file)
+    {
+        return 0;
+    }
+    
+    int success = Console_WriteTrace(console, file);
+    
+    if (fclose(file) != 0)
+    {
+        success = 0;
+    }
+    
+    return success;
+}
+
+/* the rest of the script runs that many frames later */
+static int _Console_Wait(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    if (!console->scriptName)
+    {
+        Console_Printf(console, "wait: only scripts can wait\n");
+        return 0;
+    }
+    
+    int frames = ConsoleArgView_IntValue(&argv[0]);
+    
+    if (frames < 0)
+    {
+        return 0;
+    }
+    
+    console->waitFrames = frames;
+    return 1;
+}
+
+/* a key code, or a one character string for its character */
+static int _Console_KeyArg(const ConsoleArgView_t* view)
+{
+    if (view->type == kConsoleVarTypeString)
+    {
+        const char* string = ConsoleArgView_StringValue(view);
+        return (string[0] && !string[1]) ? (unsigned char)string[0] : -1;
+    }
+    
+    return ConsoleArgView_IntValue(view);
+}
+
+/* bind key "command", or bind key to show it */
+static int _Console_BindCommand(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    if (argc < 1 || argc > 2)
+    {
+        Console_Printf(console, "bind: expected a key and a command\n");
+        return 0;
+    }
+    
+    int key = _Console_KeyArg(&argv[0]);
+    
+    if (key < 0 || key >= CONSOLE_KEY_MAX)
+    {
+        Console_Printf(console, "bind: bad key\n");
+        return 0;
+    }
+    
+    if (argc == 1)
+    {
+        const char* command = Console_KeyBinding(console, key);
+        Console_Printf(console, "%i : %s\n", key, command ? command : "");
+        return 1;
+    }
+    
+    if (argv[1].type != kConsoleVarTypeString)
+    {
+        return 0;
+    }
+    
+    return Console_BindKey(console, key, ConsoleArgView_StringValue(&argv[1]));
+}
+
+static int _Console_UnbindCommand(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    int key = _Console_KeyArg(&argv[0]);
+    
+    if (key < 0 || key >= CONSOLE_KEY_MAX)
+    {
+        return 0;
+    }
+    
+    Console_UnbindKey(console, key);
+    return 1;
+}
+
+#ifdef CONSOLE_PROFILE
+/* sorted table of commands that have run */
+static int _Console_Stats(ConsoleRef console, ConsoleArgRef args)
+{
+    Console_Printf(console, "%-24s %8s %6s %10s %10s %10s %10s %10s\n",
+                   "command", "calls", "failed", "parse", "lookup", "p50", "p99", "max");
+    
+    _Console_SortNames(console);
+    
+    int i;
+    for (i = 0; i < console->nameCount; i ++)
+    {
+        if (!(console->names[i].symbols & kConsoleSymbolCommand))
+        {
+            continue;
+        }
+        
+        const char* name = console->names[i].name;
+        ConsoleCommandRef command = _ConsoleIndex_Find(&console->commandIndex, name, _Console_Hash(name));
+        const ConsoleCommandStats_t* stats = &command->stats;
+        
+        if (stats->calls == 0)
+        {
+            continue;
+        }
+        
+        /* nanoseconds, parse and lookup are averages */
+        Console_Printf(console, "%-24s %8llu %6llu %10llu %10llu %10llu %10llu %10llu\n",
+                       command->name,
+                       stats->calls,
+                       stats->failures,
+                       stats->parse.count ? stats->parse.totalNanoseconds / stats->parse.count : 0ULL,
+                       stats->lookup.count ? stats->lookup.totalNanoseconds / stats->lookup.count : 0ULL,
+                       ConsoleHistogram_Percentile(&stats->handler, 0.5),
+                       ConsoleHistogram_Percentile(&stats->handler, 0.99),
+                       stats->handler.maxNanoseconds);
+    }
+    
+    return 1;
+}
+#endif
+
+ConsoleRef Console_Create(FILE* logfile)
+{
+    if (!logfile)
+    {
+        return NULL;
+    }
+    
+    ConsoleRef console = _Console_Malloc(sizeof(struct Console));
+    
+    if (console)
+    {
+        console->commands = NULL;
+        console->commandCount = 0;
+        console->commandCapacity = 0;
+        console->vars = NULL;
+        console->varCount = 0;
+        console->varCapacity = 0;
+        console->namePool = NULL;
+        console->names = NULL;
+        console->nameCount = 0;
+        console->nameCapacity = 0;
+        console->sortedNameCount = 0;
+        console->symbolGeneration = 0;
+        console->generation = 0;
+        console->dirtyBits = NULL;
+        console->dirtyGenerations = NULL;
+        console->dirtyWordCapacity = 0;
+        console->defaults = NULL;
+        console->defaultCapacity = 0;
+        console->journalGeneration = 0;
+        console->journalLength = 0;
+        console->compiled = NULL;
+#ifndef CONSOLE_NO_ASYNC_SAVE
+        console->saves = NULL;
+        console->lastSave = NULL;
+#endif
+        console->scriptName = NULL;
+        console->scriptLine = 0;
+        console->trace = NULL;
+        console->recorder = NULL;
+        console->newestSnapshot = NULL;
+        console->boundVars = NULL;
+        console->boundVarCount = 0;
+        console->boundVarCapacity = 0;
+        console->frame = 0;
+        console->executeDepth = 0;
+        console->timers = NULL;
+        console->waitFrames = 0;
+        console->bindings = NULL;
+        console->bindingCount = 0;
+        console->bindingCapacity = 0;
+        console->logFile = logfile;
+        console->outputFunc = _Console_WriteLogFile;
+        console->outputContext = logfile;
+        
+        if (!_ConsoleArena_Init(&console->arena, CONSOLE_ARENA_CHUNK_SIZE))
+        {
+            _Console_Free(console);
+            return NULL;
+        }
+        
+#ifndef CONSOLE_NO_THREADS
+        if (!_ConsoleQueue_Init(&console->queue))
+        {
+            _ConsoleArena_Shutdown(&console->arena);
+            _Console_Free(console);
+            return NULL;
+        }
+#endif
+        
+        _ConsoleIndex_Init(&console->commandIndex);
+        _ConsoleIndex_Init(&console->varIndex);
+        
+        /* built-in commands */
+        Console_RegisterCommand(console,
+                                "help",
+                                _Console_Help,
+                                0);
+        Console_RegisterCommandArgv(console,
+                                    "trace_dump",
+                                    _Console_TraceDump,
+                                    1);
+        Console_RegisterCommandArgv(console,
+                                    "wait",
+                                    _Console_Wait,
+                                    1);
+        Console_RegisterCommandArgv(console,
+                                    "bind",
+                                    _Console_BindCommand,
+                                    -1);
+        Console_RegisterCommandArgv(console,
+                                    "unbind",
+                                    _Console_UnbindCommand,
+                                    1);
+#ifdef CONSOLE_PROFILE
+        Console_RegisterCommand(console,
+                                "stats",
+                                _Console_Stats,
+                                0);
+#endif
+    }
+    
+    return console;
+}
+
+void Console_Destroy(ConsoleRef console)
+{
+    if (console)
+    {
+        /* snapshots read var types, so go before the vars */
+        while (console->newestSnapshot)
+        {
+            struct ConsoleVarSnapshot* older = console->newestSnapshot->older;
+            _ConsoleVarSnapshot_Destroy(console->newestSnapshot);
+            console->newestSnapshot = older;
+        }
+        
+        int i;
+        for (i = 0; i < console->commandCount; i ++)
+        {
+            _ConsoleCommand_Destroy(console->commands[i]);
+        }
+        
+        for (i = 0; i < console->varCount; i ++)
+        {
+            if (console->vars[i]->type == kConsoleVarTypeString)
+            {
+                _Console_Free(console->defaults[i].stringValue);
+            }
+            
+            _ConsoleVar_Destroy(console->vars[i]);
+        }
+        
+        /* their compiled commands go with the rest */
+        for (i = 0; i < console->bindingCount; i ++)
+        {
+            _Console_Free(console->bindings[i].command);
+        }
+        
+        _Console_Free(console->bindings);
+        _Console_Free(console->boundVars);
+        
+        while (console->compiled)
+        {
+            Console_ReleaseCompiled(console->compiled);
+        }
+        
+#ifndef CONSOLE_NO_ASYNC_SAVE
+        _Console_FinishSaves(console);
+#endif
+        
+        /* after saves, their threads record into it */
+        _ConsoleTrace_Destroy(console->trace);
+        
+        if (console->recorder)
+        {
+            Console_StopRecording(console);
+        }
+        
+        _ConsoleTimerWheel_Destroy(console->timers);
+        
+        struct ConsolePoolChunk* chunk = console->namePool;
+        while (chunk)
+        {
+            struct ConsolePoolChunk* next = chunk->next;
+            _Console_Free(chunk);
+            chunk = next;
+        }
+        
+        _ConsoleIndex_Shutdown(&console->commandIndex);
+        _ConsoleIndex_Shutdown(&console->varIndex);
+        _ConsoleArena_Shutdown(&console->arena);
+#ifndef CONSOLE_NO_THREADS
+        _ConsoleQueue_Shutdown(&console->queue);
+#endif
+        _Console_Free(console->commands);
+        _Console_Free(console->vars);
+        _Console_Free(console->defaults);
+        _Console_Free(console->names);
+        _Console_Free(console->dirtyBits);
+        _Console_Free(console->dirtyGenerations);
+        _Console_Free(console);
+    }
+}
+
+int Console_Reserve(ConsoleRef console, int varCount, int commandCount)
+{
+    assert(console);
+    assert(varCount >= 0 && commandCount >= 0);
+    
+    return _Console_ReserveVars(console, varCount) &&
+           _Console_ReserveCommands(console, commandCount);
+}
+
+void Console_MemoryStats(ConsoleRef console, ConsoleMemoryStats_t* outStats)
+{
+    assert(console);
+    assert(outStats);
+    
+    memset(outStats, 0, sizeof(ConsoleMemoryStats_t));
+    
+    outStats->varCount = (size_t)console->varCount;
+    outStats->commandCount = (size_t)console->commandCount;
+    outStats->varBytes = sizeof(struct ConsoleVar) * (size_t)console->varCount;
+    outStats->commandBytes = sizeof(struct ConsoleCommand) * (size_t)console->commandCount;
+    
+    int i;
+    for (i = 0; i < console->commandCount; i ++)
+    {
+        if (console->commands[i]->signature)
+        {
+            outStats->commandBytes += (size_t)console->commands[i]->argCount + 1;
+        }
+    }
+    
+    for (i = 0; i < console->varCount; i ++)
+    {
+        if (console->vars[i]->listener)
+        {
+            outStats->varBytes += sizeof(struct ConsoleVarListener);
+        }
+        
+        if (console->vars[i]->internal & kConsoleVarInternalHeapString)
+        {
+            outStats->stringBytes += console->vars[i]->value.heap.capacity;
+        }
+        
+        if (console->vars[i]->type == kConsoleVarTypeString && console->defaults[i].stringValue)
+        {
+            outStats->stringBytes += strlen(console->defaults[i].stringValue) + 1;
+        }
+        
+#ifndef CONSOLE_NO_THREADS
+        if ((console->vars[i]->internal & kConsoleVarInternalConcurrent) &&
+            console->vars[i]->type == kConsoleVarTypeString)
+        {
+            outStats->stringBytes += sizeof(struct ConsoleSharedString);
+        }
+#endif
+    }
+    
+    const struct ConsolePoolChunk* chunk;
+    for (chunk = console->namePool; chunk; chunk = chunk->next)
+    {
+        outStats->nameBytes += sizeof(struct ConsolePoolChunk) + chunk->size;
+    }
+    
+    outStats->indexBytes = sizeof(unsigned long long) * 2 * (size_t)console->dirtyWordCapacity +
+                           sizeof(ConsoleVarRef) * (size_t)(console->varCapacity + console->boundVarCapacity) +
+                           sizeof(union ConsoleVarDefault) * (size_t)console->defaultCapacity +
+                           sizeof(ConsoleCommandRef) * (size_t)console->commandCapacity +
+                           sizeof(struct ConsoleName) * (size_t)console->nameCapacity +
+                           sizeof(struct ConsoleIndexSlot) * (console->varIndex.capacity + console->commandIndex.capacity);
+    
+    outStats->totalBytes = sizeof(struct Console) +
+                           outStats->varBytes +
+                           outStats->commandBytes +
+                           outStats->nameBytes +
+                           outStats->stringBytes +
+                           outStats->indexBytes;
+}
+
+unsigned long long Console_Generation(ConsoleRef console)
+{
+    assert(console);
+    return console->generation;
+}
+
+/* index of the lowest set bit, bits must not be 0 */
+static int _Console_LowestBit(unsigned long long bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    /* isolate the bit, a de Bruijn sequence puts a unique pattern in the top 6 bits */
+    static const unsigned char positions[64] = {
+        0, 1, 2, 53, 3, 7, 54, 27, 4, 38, 41, 8, 34, 55, 48, 28,
+        62, 5, 39, 46, 44, 42, 22, 9, 24, 35, 59, 56, 49, 18, 29, 11,
+        63, 52, 6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+        51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12
+    };
+    return positions[((bits & (0 - bits)) * 0x022FDD63CC95386Dull) >> 58];
+#endif
+}
+
+/*
+ scan words of var bits whose latest change is after generation.
+ mask limits the scan to a var set, NULL scans every var.
+ bits stay set since any older generation may still be asked about,
+ so a word with a new change costs a check per var in it ever changed
+ */
+static int _Console_CollectChanged(ConsoleRef console,
+                                   const unsigned long long* mask,
+                                   int firstWord,
+                                   int wordCount,
+                                   unsigned long long generation,
+                                   ConsoleVarRef* outVars,
+                                   int maxVars)
+{
+    int found = 0;
+    
+    int word;
+    for (word = firstWord; word < wordCount && found < maxVars; word ++)
+    {
+        if (console->dirtyGenerations[word] <= generation)
+        {
+            continue;
+        }
+        
+        unsigned long long bits = console->dirtyBits[word];
+        
+        if (mask)
+        {
+            bits &= mask[word];
+        }
+        
+        while (bits && found < maxVars)
+        {
+            int bit = _Console_LowestBit(bits);
+            bits &= bits - 1;
+            
+            ConsoleVarRef var = console->vars[word * 64 + bit];
+            
+            if (var->generation > generation)
+            {
+                outVars[found] = var;
+                found++;
+            }
+        }
+    }
+    
+    return found;
+}
+
+int Console_ChangedVars(ConsoleRef console, unsigned long long generation, ConsoleVarRef* outVars, int maxVars)
+{
+    assert(console);
+    assert(outVars || maxVars == 0);
+    
+    return _Console_CollectChanged(console,
+                                   NULL,
+                                   0,
+                                   (console->varCount + 63) / 64,
+                                   generation,
+                                   outVars,
+                                   maxVars);
+}
+
+ConsoleVarSetRef ConsoleVarSet_Create(ConsoleRef console)
+{
+    assert(console);
+    
+    ConsoleVarSetRef set = _Console_Malloc(sizeof(struct ConsoleVarSet));
+    
+    if (set)
+    {
+        set->console = console;
+        set->bits = NULL;
+        set->wordCount = 0;
+    }
+    
+    return set;
+}
+
+void ConsoleVarSet_Destroy(ConsoleVarSetRef set)
+{
+    if (set)
+    {
+        _Console_Free(set->bits);
+        _Console_Free(set);
+    }
+}
+
+int ConsoleVarSet_Add(ConsoleVarSetRef set, ConsoleVarRef var)
+{
+    assert(set);
+    assert(var);
+    assert(var->console == set->console);
+    
+    int word = (int)(var->index / 64);
+    
+    if (word >= set->wordCount)
+    {
+        unsigned long long* bits = _Console_GrowWords(set->bits, set->wordCount, word + 1);
+        
+        if (!bits)
+        {
+            return 0;
+        }
+        
+        set->bits = bits;
+        set->wordCount = word + 1;
+    }
+    
+    set->bits[word] |= (unsigned long long)1 << (var->index % 64);
+    return 1;
+}
+
+int ConsoleVarSet_Changed(ConsoleVarSetRef set, unsigned long long generation, ConsoleVarRef* outVars, int maxVars)
+{
+    assert(set);
+    assert(outVars || maxVars == 0);
+    
+    return _Console_CollectChanged(set->console,
+                                   set->bits,
+                                   0,
+                                   set->wordCount,
+                                   generation,
+                                   outVars,
+                                   maxVars);
+}
+
+ConsoleVarRef Console_FindVar(ConsoleRef console, const char* name)
+{
+    assert(console);
+    assert(name);
+    
+    return _ConsoleIndex_Find(&console->varIndex, name, _Console_Hash(name));
+}
+
+static ConsoleCommandRef _Console_FindCommand(ConsoleRef console, const char* name)
+{
+    return _ConsoleIndex_Find(&console->commandIndex, name, _Console_Hash(name));
+}
+
+#ifdef CONSOLE_PROFILE
+int Console_GetStats(ConsoleRef console, const char* commandName, ConsoleCommandStats_t* outStats)
+{
+    assert(console);
+    assert(commandName);
+    assert(outStats);
+    
+    ConsoleCommandRef command = _Console_FindCommand(console, commandName);
+    
+    if (!command)
+    {
+        return 0;
+    }
+    
+    *outStats = command->stats;
+    return 1;
+}
+
+void Console_ResetStats(ConsoleRef console)
+{
+    assert(console);
+    
+    int i;
+    for (i = 0; i < console->commandCount; i ++)
+    {
+        ConsoleCommandRef command = console->commands[i];
+        memset(&command->stats, 0, sizeof(ConsoleCommandStats_t));
+        command->stats.name = command->name;
+    }
+}
+#endif
+
+int Console_Complete(ConsoleRef console, const char* prefix, ConsoleNameCallback_t callback, void* context)
+{
+    assert(console);
+    assert(prefix);
+    assert(callback);
+    
+    _Console_SortNames(console);
+    
+    size_t length = strlen(prefix);
+    int matches = 0;
+    
+    int i;
+    for (i = _Console_LowerName(console, prefix, length); i < console->nameCount; i ++)
+    {
+        const struct ConsoleName* entry = console->names + i;
+        
+        if (strncmp(entry->name, prefix, length) != 0)
+        {
+            break;
+        }
+        
+        callback(entry->name, entry->symbols, context);
+        ++matches;
+    }
+    
+    return matches;
+}
+
+/* '*' matches any run of characters and '?' any one */
+static int _Console_GlobMatch(const char* pattern, const char* name)
+{
+    const char* star = NULL;
+    const char* resume = NULL;
+    
+    while (*name)
+    {
+        if (*pattern == '*')
+        {
+            star = pattern++;
+            resume = name;
+        }
+        else if (*pattern == '?' || *pattern == *name)
+        {
+            ++pattern;
+            ++name;
+        }
+        else if (star)
+        {
+            /* let the last star take one more character */
+            pattern = star + 1;
+            name = ++resume;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    
+    while (*pattern == '*')
+    {
+        ++pattern;
+    }
+    
+    return *pattern == '\0';
+}
+
+int Console_List(ConsoleRef console, const char* pattern, ConsoleNameCallback_t callback, void* context)
+{
+    assert(console);
+    assert(pattern);
+    assert(callback);
+    
+    /* only names sharing the literal prefix are tested */
+    _Console_SortNames(console);
+    
+    size_t length = strcspn(pattern, "*?");
+    int matches = 0;
+    
+    int i;
+    for (i = _Console_LowerName(console, pattern, length); i < console->nameCount; i ++)
+    {
+        const struct ConsoleName* entry = console->names + i;
+        
+        if (strncmp(entry->name, pattern, length) != 0)
+        {
+            break;
+        }
+        
+        if (_Console_GlobMatch(pattern + length, entry->name + length))
+        {
+            callback(entry->name, entry->symbols, context);
+            ++matches;
+        }
+    }
+    
+    return matches;
+}
+
+/*
+ shortest round trip double formatting, after Grisu2
+ (Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+ Accurately with Integers"). values are scaled by a cached power of
+ ten so digits come from 64 bit integer arithmetic.
+ */
+struct ConsoleDiyFp
+{
+    uint64_t f;
+    int e;
+};
+
+/* normalized 10^k for k = -348, -340, ..., 340 */
+static const uint64_t _Console_CachedPowersF[] = {
+    0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+    0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+    0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+    0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+    0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+    0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+    0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+    0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+    0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+    0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+    0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+    0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+    0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+    0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+    0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+    0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+    0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+    0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+    0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+    0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+    0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+    0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+    0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+    0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+    0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+    0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+    0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+    0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+    0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull,
+};
+
+static const short _Console_CachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static const uint64_t _Console_Pow10[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+#define CONSOLE_DP_HIDDEN_BIT 0x0010000000000000ull
+#define CONSOLE_DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFull
+
+static struct ConsoleDiyFp _ConsoleDiyFp_Make(uint64_t f, int e)
+{
+    struct ConsoleDiyFp result;
+    result.f = f;
+    result.e = e;
+    return result;
+}
+
+/* rounded upper 64 bits of the product */
+static struct ConsoleDiyFp _ConsoleDiyFp_Multiply(struct ConsoleDiyFp x, struct ConsoleDiyFp y)
+{
+    const uint64_t mask = 0xFFFFFFFFull;
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & mask;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & mask;
+    
+    uint64_t ac = a * c;
+    uint64_t bc = b * c;
+    uint64_t ad = a * d;
+    uint64_t bd = b * d;
+    
+    uint64_t tmp = (bd >> 32) + (ad & mask) + (bc & mask);
+    tmp += 1ull << 31;
+    
+    return _ConsoleDiyFp_Make(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+}
+
+static struct ConsoleDiyFp _ConsoleDiyFp_Normalize(struct ConsoleDiyFp x)
+{
+    while (!(x.f & (1ull << 63)))
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    
+    return x;
+}
+
+static void _Console_GrisuRound(char* buffer, int length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t wpw)
+{
+    while (rest < wpw && delta - rest >= tenKappa &&
+           (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw))
+    {
+        buffer[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+static int _Console_CountDigits(uint32_t n)
+{
+    int digits = 1;
+    
+    while (digits < 10 && n >= _Console_Pow10[digits])
+    {
+        digits++;
+    }
+    
+    return digits;
+}
+
+/* positive, finite, non zero values only */
+static int _Console_Grisu2(double value, char* buffer, int* outK)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    
+    int biasedE = (int)((bits >> 52) & 0x7FF);
+    uint64_t significand = bits & CONSOLE_DP_SIGNIFICAND_MASK;
+    struct ConsoleDiyFp v = (biasedE != 0) ?
+        _ConsoleDiyFp_Make(significand + CONSOLE_DP_HIDDEN_BIT, biasedE - 1075) :
+        _ConsoleDiyFp_Make(significand, -1074);
+    
+    /* boundaries halfway to the neighboring doubles */
+    struct ConsoleDiyFp plus = _ConsoleDiyFp_Make((v.f << 1) + 1, v.e - 1);
+    while (!(plus.f & (CONSOLE_DP_HIDDEN_BIT << 1)))
+    {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 10;
+    plus.e -= 10;
+    
+    struct ConsoleDiyFp minus = (v.f == CONSOLE_DP_HIDDEN_BIT) ?
+        _ConsoleDiyFp_Make((v.f << 2) - 1, v.e - 2) :
+        _ConsoleDiyFp_Make((v.f << 1) - 1, v.e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    
+    /* a power of ten bringing the exponent into [-60, -32] */
+    double dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+    
+    unsigned int index = (unsigned int)((k >> 3) + 1);
+    *outK = -(-348 + (int)index * 8);
+    struct ConsoleDiyFp cached = _ConsoleDiyFp_Make(_Console_CachedPowersF[index], _Console_CachedPowersE[index]);
+    
+    struct ConsoleDiyFp w = _ConsoleDiyFp_Multiply(_ConsoleDiyFp_Normalize(v), cached);
+    struct ConsoleDiyFp wp = _ConsoleDiyFp_Multiply(plus, cached);
+    struct ConsoleDiyFp wm = _ConsoleDiyFp_Multiply(minus, cached);
+    wm.f++;
+    wp.f--;
+    
+    /* generate digits of wp until they are inside the boundaries */
+    uint64_t delta = wp.f - wm.f;
+    struct ConsoleDiyFp one = _ConsoleDiyFp_Make(1ull << -wp.e, wp.e);
+    uint64_t wpw = wp.f - w.f;
+    uint32_t p1 = (uint32_t)(wp.f >> -one.e);
+    uint64_t p2 = wp.f & (one.f - 1);
+    int kappa = _Console_CountDigits(p1);
+    int length = 0;
+    
+    while (kappa > 0)
+    {
+        uint32_t d = p1 / (uint32_t)_Console_Pow10[kappa - 1];
+        p1 %= (uint32_t)_Console_Pow10[kappa - 1];
+        
+        if (d || length)
+        {
+            buffer[length++] = (char)('0' + d);
+        }
+        
+        kappa--;
+        
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        
+        if (rest <= delta)
+        {
+            *outK += kappa;
+            _Console_GrisuRound(buffer, length, delta, rest, _Console_Pow10[kappa] << -one.e, wpw);
+            return length;
+        }
+    }
+    
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+        
+        char d = (char)(p2 >> -one.e);
+        
+        if (d || length)
+        {
+            buffer[length++] = (char)('0' + d);
+        }
+        
+        p2 &= one.f - 1;
+        kappa--;
+        
+        if (p2 < delta)
+        {
+            *outK += kappa;
+            _Console_GrisuRound(buffer, length, delta, p2, one.f, wpw * (-kappa < 20 ? _Console_Pow10[-kappa] : 0));
+            return length;
+        }
+    }
+}
+
+/* writes a non negative int, returns its length */
+static int _Console_WriteDigits(unsigned int value, char* buffer)
+{
+    char digits[10];
+    int count = 0;
+    
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    
+    int i;
+    for (i = 0; i < count; i ++)
+    {
+        buffer[i] = digits[count - 1 - i];
+    }
+    
+    return count;
+}
+
+int Console_FormatInt(int value, char* buffer)
+{
+    assert(buffer);
+    
+    int length = 0;
+    unsigned int magnitude = (unsigned int)value;
+    
+    if (value < 0)
+    {
+        buffer[length++] = '-';
+        magnitude = 0u - magnitude;
+    }
+    
+    length += _Console_WriteDigits(magnitude, buffer + length);
+    buffer[length] = '\0';
+    return length;
+}
+
+int Console_FormatDouble(double value, char* buffer)
+{
+    assert(buffer);
+    
+    char* it = buffer;
+    
+    if (value != value)
+    {
+        memcpy(buffer, "nan", 4);
+        return 3;
+    }
+    
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    
+    if (bits >> 63)
+    {
+        *it++ = '-';
+        value = -value;
+    }
+    
+    if (value == 0.0)
+    {
+        memcpy(it, "0.0", 4);
+        return (int)(it - buffer) + 3;
+    }
+    
+    if (value == HUGE_VAL)
+    {
+        memcpy(it, "inf", 4);
+        return (int)(it - buffer) + 3;
+    }
+    
+    int k;
+    int length = _Console_Grisu2(value, it, &k);
+    
+    /* the value is digits * 10^k, place the point */
+    int point = length + k;
+    
+    if (k >= 0 && point <= 21)
+    {
+        /* 1234e7 -> 12340000000.0 */
+        memset(it + length, '0', (size_t)k);
+        it += point;
+        memcpy(it, ".0", 2);
+        it += 2;
+    }
+    else if (point > 0 && point <= 21)
+    {
+        /* 1234e-2 -> 12.34 */
+        memmove(it + point + 1, it + point, (size_t)(length - point));
+        it[point] = '.';
+        it += length + 1;
+    }
+    else if (point > -6 && point <= 0)
+    {
+        /* 1234e-6 -> 0.001234 */
+        int offset = 2 - point;
+        memmove(it + offset, it, (size_t)length);
+        it[0] = '0';
+        it[1] = '.';
+        memset(it + 2, '0', (size_t)(offset - 2));
+        it += offset + length;
+    }
+    else
+    {
+        /* 1234e30 -> 1.234e33 */
+        if (length > 1)
+        {
+            memmove(it + 2, it + 1, (size_t)(length - 1));
+            it[1] = '.';
+            it += length + 1;
+        }
+        else
+        {
+            it += 1;
+        }
+        
+        *it++ = 'e';
+        
+        int exponent = point - 1;
+        if (exponent < 0)
+        {
+            *it++ = '-';
+            exponent = -exponent;
+        }
+        
+        it += _Console_WriteDigits((unsigned int)exponent, it);
+    }
+    
+    *it = '\0';
+    return (int)(it - buffer);
+}
+
+/* copy a var's value, strings onto the heap - returns success */
+static int _ConsoleVar_Capture(ConsoleVarRef var, union ConsoleVarDefault* outValue)
+{
+    switch (var->type)
+    {
+        case kConsoleVarTypeString:
+        {
+            const char* string = ConsoleVar_StringValue(var);
+            size_t length = strlen(string) + 1;
+            char* copy = NULL;
+            
+            if (length > 1)
+            {
+                copy = _Console_Malloc(length);
+                
+                if (!copy)
+                {
+                    return 0;
+                }
+                
+                memcpy(copy, string, length);
+            }
+            
+            outValue->stringValue = copy;
+            break;
+        }
+        case kConsoleVarTypeDouble:
+            outValue->doubleValue = ConsoleVar_DoubleValue(var);
+            break;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            outValue->intValue = ConsoleVar_IntValue(var);
+            break;
+        default:
+            break;
+    }
+    
+    return 1;
+}
+
+/* set a var to a captured value, notifying as any change does */
+static void _ConsoleVar_Apply(ConsoleVarRef var, const union ConsoleVarDefault* value)
+{
+    switch (var->type)
+    {
+        case kConsoleVarTypeString:
+            ConsoleVar_SetStringValue(var, value->stringValue ? value->stringValue : "");
+            break;
+        case kConsoleVarTypeDouble:
+            ConsoleVar_SetDoubleValue(var, value->doubleValue);
+            break;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            ConsoleVar_SetIntValue(var, value->intValue);
+            break;
+        default:
+            break;
+    }
+}
+
+void ConsoleVar_MarkDefault(ConsoleVarRef var)
+{
+    assert(var);
+    assert(var->console);
+    
+    union ConsoleVarDefault* value = &var->console->defaults[var->index];
+    union ConsoleVarDefault captured;
+    
+    if (!_ConsoleVar_Capture(var, &captured))
+    {
+        return;
+    }
+    
+    if (var->type == kConsoleVarTypeString)
+    {
+        _Console_Free(value->stringValue);
+    }
+    
+    *value = captured;
+}
+
+int ConsoleVar_Modified(ConsoleVarRef var)
+{
+    assert(var);
+    assert(var->console);
+    
+    const union ConsoleVarDefault* value = &var->console->defaults[var->index];
+    
+    switch (var->type)
+    {
+        case kConsoleVarTypeString:
+            return strcmp(ConsoleVar_StringValue(var), value->stringValue ? value->stringValue : "") != 0;
+        case kConsoleVarTypeDouble:
+            return !_Console_SameDouble(ConsoleVar_DoubleValue(var), value->doubleValue);
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            return ConsoleVar_IntValue(var) != value->intValue;
+        default:
+            break;
+    }
+    
+    return 0;
+}
+
+void ConsoleVar_ResetToDefault(ConsoleVarRef var)
+{
+    assert(var);
+    assert(var->console);
+    
+    _ConsoleVar_Apply(var, &var->console->defaults[var->index]);
+}
+
+void Console_MarkDefaults(ConsoleRef console)
+{
+    assert(console);
+    
+    int i;
+    for (i = 0; i < console->varCount; i ++)
+    {
+        ConsoleVar_MarkDefault(console->vars[i]);
+    }
+}
+
+/* save a var's value before its first change since the newest snapshot */
+static void _ConsoleVarSnapshot_Preserve(struct ConsoleVarSnapshot* snapshot, ConsoleVarRef var)
+{
+    struct ConsoleVarSnapshotChange* changes = _Console_ReserveArray(snapshot->changes, sizeof(struct ConsoleVarSnapshotChange), snapshot->changeCount, &snapshot->changeCapacity, snapshot->changeCount + 1);
+    
+    if (!changes)
+    {
+        return;
+    }
+    
+    snapshot->changes = changes;
+    
+    struct ConsoleVarSnapshotChange* change = &changes[snapshot->changeCount];
+    change->var = var;
+    
+    if (_ConsoleVar_Capture(var, &change->value))
+    {
+        snapshot->changeCount++;
+    }
+}
+
+/* newest first so older values win, as they do when restoring */
+static void _ConsoleVarSnapshot_Apply(const struct ConsoleVarSnapshot* snapshot)
+{
+    int i;
+    for (i = snapshot->changeCount - 1; i >= 0; i --)
+    {
+        _ConsoleVar_Apply(snapshot->changes[i].var, &snapshot->changes[i].value);
+    }
+}
+
+static void _ConsoleVarSnapshot_Destroy(struct ConsoleVarSnapshot* snapshot)
+{
+    int i;
+    for (i = 0; i < snapshot->changeCount; i ++)
+    {
+        if (snapshot->changes[i].var->type == kConsoleVarTypeString)
+        {
+            _Console_Free(snapshot->changes[i].value.stringValue);
+        }
+    }
+    
+    _Console_Free(snapshot->changes);
+    _Console_Free(snapshot);
+}
+
+ConsoleVarSnapshotRef Console_Snapshot(ConsoleRef console)
+{
+    assert(console);
+    
+    struct ConsoleVarSnapshot* snapshot = _Console_Malloc(sizeof(struct ConsoleVarSnapshot));
+    
+    if (!snapshot)
+    {
+        return NULL;
+    }
+    
+    /* values are copied by the first change after this, except bound ones below */
+    snapshot->console = console;
+    snapshot->generation = console->generation;
+    snapshot->changes = NULL;
+    snapshot->changeCount = 0;
+    snapshot->changeCapacity = 0;
+    snapshot->released = 0;
+    snapshot->newer = NULL;
+    snapshot->older = console->newestSnapshot;
+    
+    if (snapshot->older)
+    {
+        snapshot->older->newer = snapshot;
+    }
+    
+    console->newestSnapshot = snapshot;
+    
+    int i;
+    for (i = 0; i < console->boundVarCount; i ++)
+    {
+        _ConsoleVarSnapshot_Preserve(snapshot, console->boundVars[i]);
+    }
+    
+    return snapshot;
+}
+
+void Console_Restore(ConsoleRef console, ConsoleVarSnapshotRef snapshot)
+{
+    assert(console);
+    assert(snapshot);
+    assert(snapshot->console == console);
+    assert(!snapshot->released);
+    
+    /* newer snapshots are dropped, their changes are undone first */
+    struct ConsoleVarSnapshot* newer = console->newestSnapshot;
+    console->newestSnapshot = snapshot;
+    snapshot->newer = NULL;
+    
+    while (newer != snapshot)
+    {
+        struct ConsoleVarSnapshot* older = newer->older;
+        _ConsoleVarSnapshot_Apply(newer);
+        _ConsoleVarSnapshot_Destroy(newer);
+        newer = older;
+    }
+    
+    /* changed vars now have generations past the snapshot, so nothing is saved again */
+    _ConsoleVarSnapshot_Apply(snapshot);
+}
+
+void Console_ReleaseSnapshot(ConsoleVarSnapshotRef snapshot)
+{
+    if (!snapshot)
+    {
+        return;
+    }
+    
+    ConsoleRef console = snapshot->console;
+    struct ConsoleVarSnapshot* older = snapshot->older;
+    snapshot->released = 1;
+    
+    /* the older snapshot needs these values to restore vars first changed after this one */
+    if (older && snapshot->changeCount > 0)
+    {
+        struct ConsoleVarSnapshotChange* changes = _Console_ReserveArray(older->changes, sizeof(struct ConsoleVarSnapshotChange), older->changeCount, &older->changeCapacity, older->changeCount + snapshot->changeCount);
+        
+        if (!changes)
+        {
+            /* stays in the chain until a restore or the console frees it */
+            return;
+        }
+        
+        older->changes = changes;
+        memcpy(changes + older->changeCount, snapshot->changes, sizeof(struct ConsoleVarSnapshotChange) * (size_t)snapshot->changeCount);
+        older->changeCount += snapshot->changeCount;
+        snapshot->changeCount = 0;
+    }
+    
+    if (older)
+    {
+        older->newer = snapshot->newer;
+    }
+    
+    if (snapshot->newer)
+    {
+        snapshot->newer->older = older;
+    }
+    else
+    {
+        console->newestSnapshot = older;
+    }
+    
+    _ConsoleVarSnapshot_Destroy(snapshot);
+}
+
+/* one "name : value" line */
+static void _Console_WriteSaveLine(FILE* outFile, const char* name, const ConsoleArgView_t* view)
+{
+    char number[CONSOLE_NUMBER_STRING_MAX];
+    const char* value = "";
+    
+    switch (view->type)
+    {
+        case kConsoleVarTypeString:
+            value = view->value.stringValue;
+            break;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            Console_FormatInt(view->value.intValue, number);
+            value = number;
+            break;
+        case kConsoleVarTypeDouble:
+            /* shortest digits that load back to the same double */
+            Console_FormatDouble(view->value.doubleValue, number);
+            value = number;
+            break;
+        default:
+            break;
+    }
+    
+    fputs(name, outFile);
+    fputs(" : ", outFile);
+    fputs(value, outFile);
+    fputc('\n', outFile);
+}
+
+static void _Console_SaveVar(ConsoleVarRef var, FILE* outFile)
+{
+    ConsoleArgView_t view;
+    view.var = var;
+    _ConsoleArgView_Load(&view);
+    
+    _Console_WriteSaveLine(outFile, var->name, &view);
+}
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+/*
+ a binding saves as "bind : key command", the value written into
+ outValue when given - returns its size with the terminator
+ */
+static size_t _Console_FormatBinding(int key, const char* command, char* outValue)
+{
+    char number[CONSOLE_NUMBER_STRING_MAX];
+    Console_FormatInt(key, number);
+    
+    size_t numberLength = strlen(number);
+    size_t commandLength = strlen(command);
+    
+    if (outValue)
+    {
+        memcpy(outValue, number, numberLength);
+        outValue[numberLength] = ' ';
+        memcpy(outValue + numberLength + 1, command, commandLength + 1);
+    }
+    
+    return numberLength + commandLength + 2;
+}
+#endif
+
+static void _Console_SaveBindings(ConsoleRef console, FILE* outFile)
+{
+    int key;
+    for (key = 0; key < console->bindingCount; key ++)
+    {
+        const char* command = console->bindings[key].command;
+        
+        if (!command)
+        {
+            continue;
+        }
+        
+        char number[CONSOLE_NUMBER_STRING_MAX];
+        Console_FormatInt(key, number);
+        
+        fputs("bind : ", outFile);
+        fputs(number, outFile);
+        fputc(' ', outFile);
+        fputs(command, outFile);
+        fputc('\n', outFile);
+    }
+}
+
+void Console_Save(ConsoleRef console, FILE* outFile)
+{
+    assert(console);
+    assert(outFile);
+    
+    int traced = _Console_TraceBegin(console, "Console_Save");
+    
+    for (int i = 0; i < console->varCount; i ++)
+    {
+        /* don't save readonly variables */
+        if (ConsoleVar_Readonly(console->vars[i]))
+        {
+            continue;
+        }
+        
+        _Console_SaveVar(console->vars[i], outFile);
+    }
+    
+    _Console_SaveBindings(console, outFile);
+    
+    _Console_TraceEnd(console, traced);
+}
+
+void Console_SaveModified(ConsoleRef console, FILE* outFile)
+{
+    assert(console);
+    assert(outFile);
+    
+    int traced = _Console_TraceBegin(console, "Console_SaveModified");
+    
+    int i;
+    for (i = 0; i < console->varCount; i ++)
+    {
+        ConsoleVarRef var = console->vars[i];
+        
+        if (!ConsoleVar_Readonly(var) && ConsoleVar_Modified(var))
+        {
+            _Console_SaveVar(var, outFile);
+        }
+    }
+    
+    _Console_TraceEnd(console, traced);
+}
+
+int Console_AppendJournal(ConsoleRef console, FILE* journalFile)
+{
+    assert(console);
+    assert(journalFile);
+    
+    ConsoleVarRef changed[64];
+    int written = 0;
+    
+    /* only words holding a change since the last append are visited */
+    int wordCount = (console->varCount + 63) / 64;
+    int word;
+    for (word = 0; word < wordCount; word ++)
+    {
+        int count = _Console_CollectChanged(console, NULL, word, word + 1, console->journalGeneration, changed, 64);
+        
+        int i;
+        for (i = 0; i < count; i ++)
+        {
+            if (!ConsoleVar_Readonly(changed[i]))
+            {
+                _Console_SaveVar(changed[i], journalFile);
+                written++;
+            }
+        }
+    }
+    
+    console->journalGeneration = console->generation;
+    console->journalLength += written;
+    
+    if (ferror(journalFile))
+    {
+        return -1;
+    }
+    
+    return written;
+}
+
+int Console_CompactJournal(ConsoleRef console, FILE* journalFile)
+{
+    assert(console);
+    assert(journalFile);
+    
+    Console_SaveModified(console, journalFile);
+    
+    console->journalGeneration = console->generation;
+    console->journalLength = 0;
+    
+    return !ferror(journalFile);
+}
+
+int Console_JournalLength(ConsoleRef console)
+{
+    assert(console);
+    return console->journalLength;
+}
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+/* worker side, writes a temp file and renames it over the path */
+static int _ConsoleSaveJob_Write(struct ConsoleSaveJob* job)
+{
+    FILE* file = fopen(job->tempPath, "w");
+    
+    if (!file)
+    {
+        return 0;
+    }
+    
+    int i;
+    for (i = 0; i < job->entryCount; i ++)
+    {
+        _Console_WriteSaveLine(file, job->entries[i].name, &job->entries[i].view);
+    }
+    
+    /* the data must be on disk before the rename makes it visible */
+    int success = fflush(file) == 0 && !ferror(file) && fsync(fileno(file)) == 0;
+    
+    if (fclose(file) != 0)
+    {
+        success = 0;
+    }
+    
+    if (!success || rename(job->tempPath, job->path) != 0)
+    {
+        remove(job->tempPath);
+        return 0;
+    }
+    
+    /* and the rename itself, best effort */
+    int directory = open(job->directory, O_RDONLY);
+    
+    if (directory >= 0)
+    {
+        fsync(directory);
+        close(directory);
+    }
+    
+    return 1;
+}
+
+static void* _ConsoleSaveJob_Run(void* context)
+{
+    struct ConsoleSaveJob* job = context;
+    
+    int traced = _ConsoleTrace_Begin(job->trace, "Console_SaveAsync", 17);
+    job->success = _ConsoleSaveJob_Write(job);
+    _ConsoleTrace_End(job->trace, traced);
+
+    atomic_store_explicit(&job->done, 1, memory_order_release);
+    
+    return NULL;
+}
+
+static void _ConsoleSaveJob_Start(struct ConsoleSaveJob* job)
+{
+    job->started = pthread_create(&job->thread, NULL, _ConsoleSaveJob_Run, job) == 0;
+    
+    /* no thread, save now rather than never */
+    if (!job->started)
+    {
+        _ConsoleSaveJob_Run(job);
+    }
+}
+
+static void _ConsoleSaveJob_Destroy(struct ConsoleSaveJob* job)
+{
+    _Console_Free(job->path);
+    _Console_Free(job->entries);
+    _Console_Free(job->strings);
+    _Console_Free(job);
+}
+
+/* copy the values to save, the only part done on the calling thread */
+static struct ConsoleSaveJob* _ConsoleSaveJob_Create(ConsoleRef console, const char* path)
+{
+    struct ConsoleSaveJob* job = _Console_Malloc(sizeof(struct ConsoleSaveJob));
+    
+    if (!job)
+    {
+        return NULL;
+    }
+    
+    memset(job, 0, sizeof(struct ConsoleSaveJob));
+    atomic_init(&job->done, 0);
+    job->trace = console->trace;
+    
+    const char* slash = strrchr(path, '/');
+    size_t pathLength = strlen(path);
+    size_t directoryLength = slash ? (size_t)(slash - path) + 1 : 1;
+    
+    job->path = _Console_Malloc(pathLength * 2 + directoryLength + 7);
+    
+    int entryCount = 0;
+    size_t stringBytes = 0;
+    
+    int i;
+    for (i = 0; i < console->varCount; i ++)
+    {
+        if (!ConsoleVar_Readonly(console->vars[i]))
+        {
+            entryCount++;
+            
+            if (console->vars[i]->type == kConsoleVarTypeString)
+            {
+                stringBytes += strlen(ConsoleVar_StringValue(console->vars[i])) + 1;
+            }
+        }
+    }
+    
+    for (i = 0; i < console->bindingCount; i ++)
+    {
+        if (console->bindings[i].command)
+        {
+            entryCount++;
+            stringBytes += _Console_FormatBinding(i, console->bindings[i].command, NULL);
+        }
+    }
+    
+    job->entries = _Console_Malloc(sizeof(struct ConsoleSaveEntry) * (entryCount ? entryCount : 1));
+    job->strings = _Console_Malloc(stringBytes ? stringBytes : 1);
+    
+    if (!job->path || !job->entries || !job->strings)
+    {
+        _ConsoleSaveJob_Destroy(job);
+        return NULL;
+    }
+    
+    job->tempPath = job->path + pathLength + 1;
+    job->directory = job->tempPath + pathLength + 5;
+    
+    memcpy(job->path, path, pathLength + 1);
+    memcpy(job->tempPath, path, pathLength);
+    memcpy(job->tempPath + pathLength, ".tmp", 5);
+    
+    if (slash)
+    {
+        memcpy(job->directory, path, directoryLength);
+        job->directory[directoryLength] = '\0';
+    }
+    else
+    {
+        memcpy(job->directory, ".", 2);
+    }
+    
+    char* string = job->strings;
+    
+    for (i = 0; i < console->varCount; i ++)
+    {
+        ConsoleVarRef var = console->vars[i];
+        
+        if (ConsoleVar_Readonly(var))
+        {
+            continue;
+        }
+        
+        struct ConsoleSaveEntry* entry = &job->entries[job->entryCount];
+        entry->name = var->name;
+        entry->view.var = var;
+        _ConsoleArgView_Load(&entry->view);
+        
+        if (entry->view.type == kConsoleVarTypeString)
+        {
+            size_t length = strlen(entry->view.value.stringValue) + 1;
+            memcpy(string, entry->view.value.stringValue, length);
+            entry->view.value.stringValue = string;
+            string += length;
+        }
+        
+        /* the worker must not touch the var */
+        entry->view.var = NULL;
+        job->entryCount++;
+    }
+    
+    for (i = 0; i < console->bindingCount; i ++)
+    {
+        if (!console->bindings[i].command)
+        {
+            continue;
+        }
+        
+        struct ConsoleSaveEntry* entry = &job->entries[job->entryCount];
+        entry->name = "bind";
+        entry->view.type = kConsoleVarTypeString;
+        entry->view.var = NULL;
+        entry->view.value.stringValue = string;
+        string += _Console_FormatBinding(i, console->bindings[i].command, string);
+        job->entryCount++;
+    }
+    
+    return job;
+}
+
+int Console_SaveAsync(ConsoleRef console,
+                      const char* path,
+                      ConsoleSaveCallback_t callback,
+                      void* context)
+{
+    assert(console);
+    assert(path);
+    
+    struct ConsoleSaveJob* job = _ConsoleSaveJob_Create(console, path);
+    
+    if (!job)
+    {
+        return 0;
+    }
+    
+    job->callback = callback;
+    job->context = context;
+    
+    if (console->lastSave)
+    {
+        console->lastSave->next = job;
+        console->lastSave = job;
+    }
+    else
+    {
+        console->saves = job;
+        console->lastSave = job;
+        _ConsoleSaveJob_Start(job);
+    }
+    
+    return 1;
+}
+
+int Console_PollSaves(ConsoleRef console)
+{
+    assert(console);
+    
+    int completed = 0;
+    
+    while (console->saves && atomic_load_explicit(&console->saves->done, memory_order_acquire))
+    {
+        struct ConsoleSaveJob* job = console->saves;
+        
+        if (job->started)
+        {
+            pthread_join(job->thread, NULL);
+        }
+        
+        /* start the next before the callback, which may queue more */
+        console->saves = job->next;
+        
+        if (console->saves)
+        {
+            _ConsoleSaveJob_Start(console->saves);
+        }
+        else
+        {
+            console->lastSave = NULL;
+        }
+        
+        if (job->callback)
+        {
+            job->callback(console, job->path, job->success, job->context);
+        }
+        
+        _ConsoleSaveJob_Destroy(job);
+        completed++;
+    }
+    
+    return completed;
+}
+
+/* on destroy, complete every save without callbacks */
+static void _Console_FinishSaves(ConsoleRef console)
+{
+    while (console->saves)
+    {
+        struct ConsoleSaveJob* job = console->saves;
+        
+        if (job->started)
+        {
+            pthread_join(job->thread, NULL);
+        }
+        else if (!atomic_load_explicit(&job->done, memory_order_acquire))
+        {
+            _ConsoleSaveJob_Run(job);
+        }
+        
+        console->saves = job->next;
+        _ConsoleSaveJob_Destroy(job);
+    }
+    
+    console->lastSave = NULL;
+}
+#endif
+
+static int _Console_LoadText(ConsoleRef console, FILE* inFile)
+{
+    assert(console);
+    assert(inFile);
+    
+    char varName[CONSOLE_VAR_NAME_MAX];
+    char varValue[CONSOLE_VAR_STRING_MAX];
+    
+    while (!feof(inFile))
+    {
+        if (fscanf(inFile, "%s : ", varName) != 0)
+        {
+            ConsoleVarRef var = Console_FindVar(console, varName);
+            
+            if (!var && strcmp(varName, "bind") == 0)
+            {
+                /* key, then the command to the end of the line */
+                int key;
+                
+                if (fscanf(inFile, "%i", &key) != 1 || !fgets(varValue, sizeof(varValue), inFile))
+                {
+                    return 0;
+                }
+                
+                char* command = varValue;
+                size_t length = strlen(command);
+                
+                while (isspace((unsigned char)*command))
+                {
+                    ++command;
+                    --length;
+                }
+                
+                while (length > 0 && isspace((unsigned char)command[length - 1]))
+                {
+                    command[--length] = '\0';
+                }
+                
+                /* reach the end of file as the other lines do */
+                fscanf(inFile, " ");
+                
+                if (!Console_BindKey(console, key, command))
+                {
+                    return 0;
+                }
+                
+                continue;
+            }
+            
+            if (!var)
+            {
+                return 0;
+            }
+            
+            switch (var->type)
+            {
+                case kConsoleVarTypeString:
+                {
+                    fscanf(inFile, "%s\n", varValue);
+                    ConsoleVar_SetStringValue(var, varValue);
+                    break;
+                }
+                case kConsoleVarTypeInt:
+                {
+                    int intVar;
+                    fscanf(inFile, "%i\n", &intVar);
+                    ConsoleVar_SetIntValue(var, intVar);
+                    break;
+                }
+                case kConsoleVarTypeBool:
+                {
+                    int intVar;
+                    fscanf(inFile, "%i\n", &intVar);
+                    ConsoleVar_SetIntValue(var, intVar);
+                    break;
+                }
+                case kConsoleVarTypeDouble:
+                {
+                    double doubleVar;
+                    fscanf(inFile, "%lf\n", &doubleVar);
+                    ConsoleVar_SetDoubleValue(var, doubleVar);
+                    break;
+                }
+                default:
+                    break;
+            }
+            
+            _Console_RecordVar(console, var);
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int Console_Load(ConsoleRef console, FILE* inFile)
+{
+    int traced = _Console_TraceBegin(console, "Console_Load");
+    int success = _Console_LoadText(console, inFile);
+    _Console_TraceEnd(console, traced);
+    return success;
+}
+
+/* assign an argument to a var, converting as set does */
+static void _ConsoleVar_Assign(ConsoleVarRef var, const ConsoleArgView_t* view)
+{
+    switch (var->type)
+    {
+        case kConsoleVarTypeString:
+            ConsoleVar_SetStringValue(var, ConsoleArgView_StringValue(view));
+            break;
+        case kConsoleVarTypeDouble:
+            ConsoleVar_SetDoubleValue(var, ConsoleArgView_DoubleValue(view));
+            break;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            ConsoleVar_SetIntValue(var, ConsoleArgView_IntValue(view));
+            break;
+        default:
+            break;
+    }
+}
+
+/* bytes a saved var adds to the names and strings section */
+static size_t _Console_SnapshotStringBytes(ConsoleVarRef var)
+{
+    size_t bytes = strlen(var->name) + 1;
+    
+    if (var->type == kConsoleVarTypeString)
+    {
+        bytes += strlen(ConsoleVar_StringValue(var)) + 1;
+    }
+    
+    return bytes;
+}
+
+static int _Console_WriteSnapshot(ConsoleRef console, FILE* outFile)
+{
+    assert(console);
+    assert(outFile);
+    
+    size_t varCount = 0;
+    size_t stringBytes = 0;
+    
+    int i;
+    for (i = 0; i < console->varCount; i ++)
+    {
+        if (!ConsoleVar_Readonly(console->vars[i]))
+        {
+            varCount++;
+            stringBytes += _Console_SnapshotStringBytes(console->vars[i]);
+        }
+    }
+    
+    size_t entriesOffset = sizeof(struct ConsoleSnapshotHeader);
+    size_t valuesOffset = entriesOffset + sizeof(struct ConsoleSnapshotEntry) * varCount;
+    size_t stringsOffset = valuesOffset + sizeof(union ConsoleSnapshotValue) * varCount;
+    size_t size = stringsOffset + stringBytes;
+    
+    if (size > UINT32_MAX)
+    {
+        return 0;
+    }
+    
+    struct ConsoleSnapshotHeader header;
+    header.magic = CONSOLE_SNAPSHOT_MAGIC;
+    header.version = CONSOLE_SNAPSHOT_VERSION;
+    header.varCount = (uint32_t)varCount;
+    header.entriesOffset = (uint32_t)entriesOffset;
+    header.valuesOffset = (uint32_t)valuesOffset;
+    header.size = (uint32_t)size;
+    
+    fwrite(&header, sizeof(header), 1, outFile);
+    
+    /* entries, values and strings are written in the same var order */
+    size_t offset = stringsOffset;
+    for (i = 0; i < console->varCount; i ++)
+    {
+        ConsoleVarRef var = console->vars[i];
+        
+        if (ConsoleVar_Readonly(var))
+        {
+            continue;
+        }
+        
+        struct ConsoleSnapshotEntry entry;
+        entry.hash = var->hash;
+        entry.nameOffset = (uint32_t)offset;
+        entry.nameLength = (uint32_t)strlen(var->name);
+        entry.type = var->type;
+        
+        fwrite(&entry, sizeof(entry), 1, outFile);
+        offset += _Console_SnapshotStringBytes(var);
+    }
+    
+    offset = stringsOffset;
+    for (i = 0; i < console->varCount; i ++)
+    {
+        ConsoleVarRef var = console->vars[i];
+        
+        if (ConsoleVar_Readonly(var))
+        {
+            continue;
+        }
+        
+        union ConsoleSnapshotValue value;
+        memset(&value, 0, sizeof(value));
+        
+        switch (var->type)
+        {
+            case kConsoleVarTypeString:
+                value.string.offset = (uint32_t)(offset + strlen(var->name) + 1);
+                value.string.length = (uint32_t)strlen(ConsoleVar_StringValue(var));
+                break;
+            case kConsoleVarTypeDouble:
+                value.doubleValue = ConsoleVar_DoubleValue(var);
+                break;
+            case kConsoleVarTypeInt:
+            case kConsoleVarTypeBool:
+                value.intValue = ConsoleVar_IntValue(var);
+                break;
+            default:
+                break;
+        }
+        
+        fwrite(&value, sizeof(value), 1, outFile);
+        offset += _Console_SnapshotStringBytes(var);
+    }
+    
+    for (i = 0; i < console->varCount; i ++)
+    {
+        ConsoleVarRef var = console->vars[i];
+        
+        if (ConsoleVar_Readonly(var))
+        {
+            continue;
+        }
+        
+        fwrite(var->name, strlen(var->name) + 1, 1, outFile);
+        
+        if (var->type == kConsoleVarTypeString)
+        {
+            const char* string = ConsoleVar_StringValue(var);
+            fwrite(string, strlen(string) + 1, 1, outFile);
+        }
+    }
+    
+    return !ferror(outFile);
+}
+
+int Console_SaveSnapshot(ConsoleRef console, FILE* outFile)
+{
+    int traced = _Console_TraceBegin(console, "Console_SaveSnapshot");
+    int success = _Console_WriteSnapshot(console, outFile);
+    _Console_TraceEnd(console, traced);
+    return success;
+}
+
+/* a terminated string inside the snapshot, NULL if out of bounds */
+static const char* _Console_SnapshotString(const unsigned char* bytes, size_t size, uint32_t offset, uint32_t length)
+{
+    if (offset >= size || size - offset <= length || bytes[offset + length] != '\0')
+    {
+        return NULL;
+    }
+    
+    return (const char*)bytes + offset;
+}
+
+/* read var i of a snapshot into name and view, returns success */
+static int _Console_SnapshotRead(const unsigned char* bytes,
+                                 size_t size,
+                                 const struct ConsoleSnapshotHeader* header,
+                                 uint32_t i,
+                                 struct ConsoleSnapshotEntry* outEntry,
+                                 const char** outName,
+                                 ConsoleArgView_t* outView)
+{
+    union ConsoleSnapshotValue value;
+    
+    /* mapped data may be unaligned for these types */
+    memcpy(outEntry, bytes + header->entriesOffset + sizeof(struct ConsoleSnapshotEntry) * i, sizeof(struct ConsoleSnapshotEntry));
+    memcpy(&value, bytes + header->valuesOffset + sizeof(union ConsoleSnapshotValue) * i, sizeof(union ConsoleSnapshotValue));
+    
+    *outName = _Console_SnapshotString(bytes, size, outEntry->nameOffset, outEntry->nameLength);
+    
+    if (!*outName)
+    {
+        return 0;
+    }
+    
+    outView->var = NULL;
+    
+    switch (outEntry->type)
+    {
+        case kConsoleVarTypeString:
+            outView->type = kConsoleVarTypeString;
+            outView->value.stringValue = _Console_SnapshotString(bytes, size, value.string.offset, value.string.length);
+            return outView->value.stringValue != NULL;
+        case kConsoleVarTypeDouble:
+            outView->type = kConsoleVarTypeDouble;
+            outView->value.doubleValue = value.doubleValue;
+            return 1;
+        case kConsoleVarTypeInt:
+        case kConsoleVarTypeBool:
+            outView->type = (ConsoleVarType_t)outEntry->type;
+            outView->value.intValue = (int)value.intValue;
+            return 1;
+        default:
+            break;
+    }
+    
+    return 0;
+}
+
+static int _Console_ApplySnapshot(ConsoleRef console, const void* data, size_t size)
+{
+    assert(console);
+    assert(data || size == 0);
+    
+    const unsigned char* bytes = data;
+    struct ConsoleSnapshotHeader header;
+    
+    if (size < sizeof(header))
+    {
+        return 0;
+    }
+    
+    memcpy(&header, bytes, sizeof(header));
+    
+    if (header.magic != CONSOLE_SNAPSHOT_MAGIC ||
+        header.version != CONSOLE_SNAPSHOT_VERSION ||
+        header.size != size ||
+        header.entriesOffset > size ||
+        header.valuesOffset > size ||
+        (size - header.entriesOffset) / sizeof(struct ConsoleSnapshotEntry) < header.varCount ||
+        (size - header.valuesOffset) / sizeof(union ConsoleSnapshotValue) < header.varCount)
+    {
+        return 0;
+    }
+    
+    struct ConsoleSnapshotEntry entry;
+    const char* name;
+    ConsoleArgView_t view;
+    
+    /* check everything first so a damaged file changes nothing */
+    uint32_t i;
+    for (i = 0; i < header.varCount; i ++)
+    {
+        if (!_Console_SnapshotRead(bytes, size, &header, i, &entry, &name, &view))
+        {
+            return 0;
+        }
+    }
+    
+    for (i = 0; i < header.varCount; i ++)
+    {
+        _Console_SnapshotRead(bytes, size, &header, i, &entry, &name, &view);
+        
+        ConsoleVarRef var = _ConsoleIndex_Find(&console->varIndex, name, entry.hash);
+        
+        /* vars no longer registered, or now readonly, are skipped */
+        if (var && !ConsoleVar_Readonly(var))
+        {
+            _ConsoleVar_Assign(var, &view);
+            _Console_RecordVar(console, var);
+        }
+    }
+    
+    return 1;
+}
+
+int Console_ApplySnapshot(ConsoleRef console, const void* data, size_t size)
+{
+    int traced = _Console_TraceBegin(console, "Console_ApplySnapshot");
+    int success = _Console_ApplySnapshot(console, data, size);
+    _Console_TraceEnd(console, traced);
+    return success;
+}
+
+/* map a whole file for reading, NULL on failure */
+static const void* _Console_MapFile(const char* path, size_t* outSize)
+{
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    
+    struct stat info;
+    
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    
+    if (data == MAP_FAILED)
+    {
+        return NULL;
+    }
+    
+    *outSize = (size_t)info.st_size;
+    return data;
+#else
+    /* no mmap, read it in */
+    FILE* file = fopen(path, "rb");
+    
+    if (!file)
+    {
+        return NULL;
+    }
+    
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        length = ftell(file);
+    }
+    
+    void* data = NULL;
+    
+    if (length > 0 && fseek(file, 0, SEEK_SET) == 0)
+    {
+        data = _Console_Malloc((size_t)length);
+        
+        if (data && fread(data, 1, (size_t)length, file) != (size_t)length)
+        {
+            _Console_Free(data);
+            data = NULL;
+        }
+    }
+    
+    fclose(file);
+    *outSize = (size_t)length;
+    return data;
+#endif
+}
+
+static void _Console_UnmapFile(const void* data, size_t size)
+{
+#if !defined(_WIN32)
+    munmap((void*)data, size);
+#else
+    _Console_Free((void*)data);
+#endif
+}
+
+int Console_LoadSnapshot(ConsoleRef console, const char* path)
+{
+    assert(console);
+    assert(path);
+    
+    int traced = _Console_TraceBegin(console, "Console_LoadSnapshot");
+    
+    size_t size = 0;
+    const void* data = _Console_MapFile(path, &size);
+    int success = 0;
+    
+    if (data)
+    {
+        success = _Console_ApplySnapshot(console, data, size);
+        _Console_UnmapFile(data, size);
+    }
+    
+    _Console_TraceEnd(console, traced);
+    return success;
+}
+
+int Console_StartTrace(ConsoleRef console, int eventsPerThread)
+{
+    assert(console);
+    assert(eventsPerThread >= 2);
+    
+    if (!console->trace)
+    {
+        struct ConsoleTrace* trace = _Console_Malloc(sizeof(struct ConsoleTrace));
+        
+        if (!trace)
+        {
+            return 0;
+        }
+        
+        trace->capacity = eventsPerThread;
+        
+#ifndef CONSOLE_NO_THREADS
+        trace->id = atomic_fetch_add_explicit(&_Console_TraceIds, 1, memory_order_relaxed);
+        atomic_init(&trace->buffers, NULL);
+        atomic_init(&trace->enabled, 0);
+        atomic_init(&trace->nextTid, 1);
+#else
+        trace->id = 1;
+        trace->buffers = NULL;
+        trace->enabled = 0;
+        trace->nextTid = 1;
+#endif
+        
+        /* the console thread shouldn't allocate mid frame */
+        if (!_ConsoleTrace_Buffer(trace))
+        {
+            _Console_Free(trace);
+            return 0;
+        }
+        
+        console->trace = trace;
+    }
+    
+#ifndef CONSOLE_NO_THREADS
+    atomic_store_explicit(&console->trace->enabled, 1, memory_order_relaxed);
+#else
+    console->trace->enabled = 1;
+#endif
+    return 1;
+}
+
+void Console_StopTrace(ConsoleRef console)
+{
+    assert(console);
+    
+    if (console->trace)
+    {
+#ifndef CONSOLE_NO_THREADS
+        atomic_store_explicit(&console->trace->enabled, 0, memory_order_relaxed);
+#else
+        console->trace->enabled = 0;
+#endif
+    }
+}
+
+/* a JSON string body */
+static void _Console_WriteJsonString(FILE* outFile, const char* text)
+{
+    for (; *text; ++text)
+    {
+        unsigned char c = (unsigned char)*text;
+        
+        if (c == '\"' || c == '\\')
+        {
+            fputc('\\', outFile);
+            fputc(c, outFile);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(outFile, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, outFile);
+        }
+    }
+}
+
+int Console_WriteTrace(ConsoleRef console, FILE* outFile)
+{
+    assert(console);
+    assert(outFile);
+    
+#ifndef _WIN32
+    long pid = (long)getpid();
+#else
+    long pid = (long)GetCurrentProcessId();
+#endif
+    
+    fputs("{\"traceEvents\":[\n", outFile);
+    
+    struct ConsoleTrace* trace = console->trace;
+    int first = 1;
+    
+#ifndef CONSOLE_NO_THREADS
+    struct ConsoleTraceBuffer* buffer = trace ? atomic_load_explicit(&trace->buffers, memory_order_acquire) : NULL;
+#else
+    struct ConsoleTraceBuffer* buffer = trace ? trace->buffers : NULL;
+#endif
+    
+    for (; buffer; buffer = buffer->next)
+    {
+        /* events past count may still be being written */
+#ifndef CONSOLE_NO_THREADS
+        int count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+#else
+        int count = buffer->count;
+#endif
+        
+        int i;
+        for (i = 0; i < count; i ++)
+        {
+            const struct ConsoleTraceEvent* event = buffer->events + i;
+            
+            /* microseconds with nanosecond precision */
+            fprintf(outFile, "%s{\"name\":\"", first ? "" : ",\n");
+            first = 0;
+            _Console_WriteJsonString(outFile, event->name);
+            fprintf(outFile, "\",\"cat\":\"console\",\"ph\":\"%c\",\"ts\":%lld.%03lld,\"pid\":%ld,\"tid\":%llu}",
+                    event->phase,
+                    event->time / 1000,
+                    event->time % 1000,
+                    pid,
+                    buffer->tid);
+        }
+    }
+    
+    fputs("\n],\"displayTimeUnit\":\"ns\"}\n", outFile);
+    
+    return !ferror(outFile);
+}
+
+int Console_TraceDropped(ConsoleRef console)
+{
+    assert(console);
+    
+    if (!console->trace)
+    {
+        return 0;
+    }
+    
+    int dropped = 0;
+    
+#ifndef CONSOLE_NO_THREADS
+    struct ConsoleTraceBuffer* buffer = atomic_load_explicit(&console->trace->buffers, memory_order_acquire);
+    for (; buffer; buffer = buffer->next)
+    {
+        dropped += atomic_load_explicit(&buffer->dropped, memory_order_relaxed);
+    }
+#else
+    struct ConsoleTraceBuffer* buffer = console->trace->buffers;
+    for (; buffer; buffer = buffer->next)
+    {
+        dropped += buffer->dropped;
+    }
+#endif
+    
+    return dropped;
+}
+
+FILE* Console_Log(ConsoleRef console)
+{
+    assert(console);
+    return console->logFile;
+}
+
+static void _Console_WriteLogFile(const char* text, size_t length, void* context)
+{
+    fwrite(text, 1, length, context);
+}
+
+void Console_SetOutput(ConsoleRef console, ConsoleOutputFunc_t outputFunc, void* context)
+{
+    assert(console);
+    
+    if (!outputFunc)
+    {
+        outputFunc = _Console_WriteLogFile;
+        context = console->logFile;
+    }
+    
+    console->outputFunc = outputFunc;
+    console->outputContext = context;
+}
+
+void Console_Write(ConsoleRef console, const char* text, size_t length)
+{
+    assert(console);
+    assert(text || length == 0);
+    
+    console->outputFunc(text, length, console->outputContext);
+}
+
+static void _Console_VPrintf(ConsoleRef console, const char* format, va_list args)
+{
+    char buffer[CONSOLE_PRINT_BUFFER_SIZE];
+    
+    va_list retry;
+    va_copy(retry, args);
+    
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    
+    if (length < 0)
+    {
+        va_end(retry);
+        return;
+    }
+    
+    if ((size_t)length < sizeof(buffer))
+    {
+        Console_Write(console, buffer, (size_t)length);
+    }
+    else
+    {
+        /* rare, long output */
+        char* large = _Console_Malloc((size_t)length + 1);
+        
+        if (large)
+        {
+            vsnprintf(large, (size_t)length + 1, format, retry);
+            Console_Write(console, large, (size_t)length);
+            _Console_Free(large);
+        }
+    }
+    
+    va_end(retry);
+}
+
+void Console_Printf(ConsoleRef console, const char* format, ...)
+{
+    assert(console);
+    assert(format);
+    
+    va_list args;
+    va_start(args, format);
+    _Console_VPrintf(console, format, args);
+    va_end(args);
+}
+
+static ConsoleCommandRef _Console_AddCommand(ConsoleRef console,
+                                             const char* name,
+                                             ConsoleFunc_t consoleFunc,
+                                             ConsoleArgvFunc_t argvFunc,
+                                             int argCount)
+{
+    assert(console);
+    assert(name);
+    
+    if (!_Console_ReserveCommands(console, console->commandCount + 1))
+    {
+        return NULL;
+    }
+    
+    ConsoleCommandRef newCommand = _ConsoleCommand_Create();
+    
+    if (!newCommand)
+    {
+        return NULL;
+    }
+    
+    newCommand->func = consoleFunc;
+    newCommand->argvFunc = argvFunc;
+    newCommand->argCount = argCount;
+    newCommand->hash = _Console_Hash(name);
+    newCommand->name = _Console_InternName(console, name, newCommand->hash);
+    
+    if (!newCommand->name)
+    {
+        _Console_Free(newCommand);
+        return NULL;
+    }
+    
+#ifdef CONSOLE_PROFILE
+    newCommand->stats.name = newCommand->name;
+#endif
+    
+    console->commands[console->commandCount] = newCommand;
+    console->commandCount++;
+    
+    if (_ConsoleIndex_Insert(&console->commandIndex, newCommand->name, newCommand->hash, newCommand))
+    {
+        console->symbolGeneration++;
+    }
+    
+    _Console_AddName(console, newCommand->name, kConsoleSymbolCommand);
+    
+    return newCommand;
+}
+
+ConsoleCommandRef Console_RegisterCommand(ConsoleRef console,
+                                          const char* name,
+                                          ConsoleFunc_t consoleFunc,
+                                          int argCount)
+{
+    assert(consoleFunc);
+    return _Console_AddCommand(console, name, consoleFunc, NULL, argCount);
+}
+
+ConsoleCommandRef Console_RegisterCommandArgv(ConsoleRef console,
+                                              const char* name,
+                                              ConsoleArgvFunc_t argvFunc,
+                                              int argCount)
+{
+    assert(argvFunc);
+    return _Console_AddCommand(console, name, NULL, argvFunc, argCount);
+}
+
+/* type of a signature character, returns success */
+static int _Console_SignatureType(char c, ConsoleVarType_t* outType)
+{
+    switch (c)
+    {
+        case 'i':
+            *outType = kConsoleVarTypeInt;
+            return 1;
+        case 'f':
+            *outType = kConsoleVarTypeDouble;
+            return 1;
+        case 'b':
+            *outType = kConsoleVarTypeBool;
+            return 1;
+        case 's':
+            *outType = kConsoleVarTypeString;
+            return 1;
+        default:
+            break;
+    }
+    
+    return 0;
+}
+
+ConsoleCommandRef Console_RegisterCommandTyped(ConsoleRef console,
+                                               const char* name,
+                                               ConsoleArgvFunc_t argvFunc,
+                                               const char* signature)
+{
+    assert(argvFunc);
+    assert(signature);
+    
+    size_t length = strlen(signature);
+    
+    size_t i;
+    for (i = 0; i < length; i ++)
+    {
+        ConsoleVarType_t type;
+        
+        if (!_Console_SignatureType(signature[i], &type))
+        {
+            return NULL;
+        }
+    }
+    
+    char* copy = _Console_Malloc(length + 1);
+    
+    if (!copy)
+    {
+        return NULL;
+    }
+    
+    memcpy(copy, signature, length + 1);
+    
+    ConsoleCommandRef newCommand = _Console_AddCommand(console, name, NULL, argvFunc, (int)length);
+    
+    if (!newCommand)
+    {
+        _Console_Free(copy);
+        return NULL;
+    }
+    
+    newCommand->signature = copy;
+    return newCommand;
+}
+
+ConsoleVarRef Console_RegisterVar(ConsoleRef console,
+                                  const char* name,
+                                  ConsoleVarType_t type,
+                                  ConsoleVarFlag_t flags)
+{
+    assert(console);
+    assert(name);
+    
+    if (!_Console_ReserveVars(console, console->varCount + 1))
+    {
+        return NULL;
+    }
+    
+    ConsoleVarRef newVar = _ConsoleVar_Create(type);
+    
+    if (!newVar)
+    {
+        return NULL;
+    }
+    
+    newVar->hash = _Console_Hash(name);
+    newVar->name = _Console_InternName(console, name, newVar->hash);
+    
+    if (!newVar->name)
+    {
+        _ConsoleVar_Destroy(newVar);
+        return NULL;
+    }
+    
+    newVar->flags = (unsigned short)flags;
+    
+#ifndef CONSOLE_NO_THREADS
+    if (flags & kConsoleVarFlagConcurrent)
+    {
+        if (!_ConsoleVar_MakeConcurrent(newVar))
+        {
+            _ConsoleVar_Destroy(newVar);
+            return NULL;
+        }
+    }
+#endif
+    
+    newVar->console = console;
+    newVar->index = (unsigned int)console->varCount;
+    
+    /* registered values are zero, bound vars mark theirs below */
+    memset(&console->defaults[console->varCount], 0, sizeof(union ConsoleVarDefault));
+    
+    console->vars[console->varCount] = newVar;
+    console->varCount++;
+    
+    /* the shadowed var stays allocated so existing refs remain valid */
+    if (_ConsoleIndex_Insert(&console->varIndex, newVar->name, newVar->hash, newVar))
+    {
+        console->symbolGeneration++;
+    }
+    
+    _Console_AddName(console, newVar->name, kConsoleSymbolVar);
+    
+    return newVar;
+}
+
+/* register a var stored at data, capacity is in bytes for strings only */
+static ConsoleVarRef _Console_BindStorage(ConsoleRef console,
+                                          const char* name,
+                                          ConsoleVarType_t type,
+                                          void* data,
+                                          size_t capacity,
+                                          ConsoleVarFlag_t flags)
+{
+    assert(console);
+    assert(!(flags & kConsoleVarFlagConcurrent));
+    
+    /* room to track it first, so failing registers nothing */
+    ConsoleVarRef* boundVars = _Console_ReserveArray(console->boundVars, sizeof(ConsoleVarRef), console->boundVarCount, &console->boundVarCapacity, console->boundVarCount + 1);
+    
+    if (!boundVars)
+    {
+        return NULL;
+    }
+    
+    console->boundVars = boundVars;
+    
+    ConsoleVarRef newVar = Console_RegisterVar(console, name, type, flags);
+    
+    if (newVar)
+    {
+        newVar->value.bound.data = data;
+        newVar->value.bound.capacity = capacity;
+        newVar->internal |= kConsoleVarInternalBound;
+        ConsoleVar_MarkDefault(newVar);
+        
+        console->boundVars[console->boundVarCount++] = newVar;
+        
+        /* as registered vars are, restored to their first value */
+        if (console->newestSnapshot)
+        {
+            _ConsoleVarSnapshot_Preserve(console->newestSnapshot, newVar);
+        }
+    }
+    
+    return newVar;
+}
+
+ConsoleVarRef Console_BindVar(ConsoleRef console,
+                              const char* name,
+                              ConsoleVarType_t type,
+                              void* storage,
+                              ConsoleVarFlag_t flags)
+{
+    assert(storage);
+    assert(type != kConsoleVarTypeString);
+    
+    return _Console_BindStorage(console, name, type, storage, 0, flags);
+}
+
+ConsoleVarRef Console_BindStringVar(ConsoleRef console,
+                                    const char* name,
+                                    char* buffer,
+                                    size_t bufferSize,
+                                    ConsoleVarFlag_t flags)
+{
+    assert(buffer);
+    assert(bufferSize > 0);
+    
+    return _Console_BindStorage(console, name, kConsoleVarTypeString, buffer, bufferSize, flags);
+}
+
+/* what _Console_ScanNumber found */
+enum
+{
+    kConsoleNumberInvalid = 0,
+    kConsoleNumberInt,
+    kConsoleNumberDouble,
+    /* a number that doesn't fit its type */
+    kConsoleNumberRange,
+};
+
+/* halfway points between doubles have at most 767 significant digits */
+#define CONSOLE_DECIMAL_DIGITS_MAX 780
+/* enough bits for those digits scaled against the smallest double */
+#define CONSOLE_BIG_LIMBS 144
+
+/* unsigned integer for exact decimal rounding */
+struct ConsoleBig
+{
+    uint32_t limbs[CONSOLE_BIG_LIMBS];
+    int count;
+};
+
+static void _ConsoleBig_MultiplyAdd(struct ConsoleBig* big, uint32_t factor, uint32_t addend)
+{
+    uint64_t carry = addend;
+    
+    for (int i = 0; i < big->count; i++)
+    {
+        carry += (uint64_t)big->limbs[i] * factor;
+        big->limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    
+    if (carry)
+    {
+        assert(big->count < CONSOLE_BIG_LIMBS);
+        big->limbs[big->count++] = (uint32_t)carry;
+    }
+}
+
+static void _ConsoleBig_MultiplyPow5(struct ConsoleBig* big, int power)
+{
+    /* 5^13 is the largest power in a limb */
+    for (; power >= 13; power -= 13)
+    {
+        _ConsoleBig_MultiplyAdd(big, 1220703125u, 0);
+    }
+    
+    uint32_t factor = 1;
+    for (; power > 0; power--)
+    {
+        factor *= 5;
+    }
+    
+    _ConsoleBig_MultiplyAdd(big, factor, 0);
+}
+
+static void _ConsoleBig_ShiftLeft(struct ConsoleBig* big, int shift)
+{
+    if (big->count == 0)
+    {
+        return;
+    }
+    
+    int words = shift / 32;
+    int bits = shift % 32;
+    
+    assert(big->count + words < CONSOLE_BIG_LIMBS);
+    
+    big->limbs[big->count + words] = 0;
+    for (int i = big->count - 1; i >= 0; i--)
+    {
+        uint32_t limb = big->limbs[i];
+        if (bits)
+        {
+            big->limbs[i + words + 1] |= limb >> (32 - bits);
+        }
+        big->limbs[i + words] = limb << bits;
+    }
+    
+    memset(big->limbs, 0, sizeof(uint32_t) * (size_t)words);
+    big->count += words + 1;
+    
+    while (big->count > 0 && big->limbs[big->count - 1] == 0)
+    {
+        big->count--;
+    }
+}
+
+static int _ConsoleBig_Compare(const struct ConsoleBig* a, const struct ConsoleBig* b)
+{
+    if (a->count != b->count)
+    {
+        return a->count < b->count ? -1 : 1;
+    }
+    
+    for (int i = a->count - 1; i >= 0; i--)
+    {
+        if (a->limbs[i] != b->limbs[i])
+        {
+            return a->limbs[i] < b->limbs[i] ? -1 : 1;
+        }
+    }
+    
+    return 0;
+}
+
+/* compares digits * 10^exponent with the point halfway above the positive double in bits */
+static int _Console_CompareHalfway(const struct ConsoleBig* digits, int exponent, uint64_t bits)
+{
+    int biasedE = (int)((bits >> 52) & 0x7FF);
+    uint64_t significand = bits & CONSOLE_DP_SIGNIFICAND_MASK;
+    
+    /* halfway is (2m + 1) * 2^(e - 1) */
+    uint64_t m = (biasedE != 0) ? significand + CONSOLE_DP_HIDDEN_BIT : significand;
+    int e = (biasedE != 0) ? biasedE - 1075 : -1074;
+    
+    struct ConsoleBig value = *digits;
+    struct ConsoleBig halfway;
+    halfway.limbs[0] = (uint32_t)(2 * m + 1);
+    halfway.limbs[1] = (uint32_t)((2 * m + 1) >> 32);
+    halfway.count = halfway.limbs[1] ? 2 : 1;
+    
+    int valueShift = 0;
+    int halfwayShift = e - 1;
+    
+    if (exponent >= 0)
+    {
+        _ConsoleBig_MultiplyPow5(&value, exponent);
+        valueShift += exponent;
+    }
+    else
+    {
+        _ConsoleBig_MultiplyPow5(&halfway, -exponent);
+        halfwayShift -= exponent;
+    }
+    
+    if (valueShift > halfwayShift)
+    {
+        _ConsoleBig_ShiftLeft(&value, valueShift - halfwayShift);
+    }
+    else
+    {
+        _ConsoleBig_ShiftLeft(&halfway, halfwayShift - valueShift);
+    }
+    
+    return _ConsoleBig_Compare(&value, &halfway);
+}
+
+/*
+ correctly round the digits of a decimal number, with or without a point,
+ times 10^exponent. starts from a close estimate and steps to the nearest
+ double, comparing exactly against the halfway points.
+ the magnitude must already be known to be in the double range
+ - returns 0 on overflow
+ */
+static int _Console_RoundDecimal(const char* it, const char* end, int exponent, double estimate, double* outValue)
+{
+    struct ConsoleBig digits;
+    digits.count = 0;
+    
+    int kept = 0;
+    /* nonzero digits past the ones kept, the value is a little larger */
+    int truncated = 0;
+    int fraction = 0;
+    
+    for (; it < end; it++)
+    {
+        if (*it == '.')
+        {
+            fraction = 1;
+            continue;
+        }
+        
+        if (kept < CONSOLE_DECIMAL_DIGITS_MAX)
+        {
+            _ConsoleBig_MultiplyAdd(&digits, 10, (uint32_t)(*it - '0'));
+            kept += digits.count > 0;
+            exponent -= fraction;
+        }
+        else
+        {
+            truncated |= *it != '0';
+            exponent += !fraction;
+        }
+    }
+    
+    uint64_t bits = 0;
+    
+    if (digits.count == 0)
+    {
+        memcpy(outValue, &bits, sizeof(bits));
+        return 1;
+    }
+    
+    const uint64_t infinity = 0x7FF0000000000000ull;
+    
+    if (estimate > 0.0)
+    {
+        memcpy(&bits, &estimate, sizeof(bits));
+        if (bits >= infinity)
+        {
+            bits = infinity - 1;
+        }
+    }
+    
+    for (;;)
+    {
+        int above = _Console_CompareHalfway(&digits, exponent, bits);
+        
+        /* ties go to the even neighbor */
+        if (above > 0 || (above == 0 && (truncated || (bits & 1))))
+        {
+            if (++bits == infinity)
+            {
+                return 0;
+            }
+            continue;
+        }
+        
+        if (bits > 0)
+        {
+            int below = _Console_CompareHalfway(&digits, exponent, bits - 1);
+            
+            if (below < 0 || (below == 0 && !truncated && (bits & 1)))
+            {
+                bits--;
+                continue;
+            }
+        }
+        
+        break;
+    }
+    
+    memcpy(outValue, &bits, sizeof(bits));
+    return 1;
+}
+
+/*
+ classify and convert a number in one pass, independent of locale:
+ ints, 0x hex ints of up to 32 bits (read as the int with those bits)
+ and doubles with a fraction and/or exponent
+ */
+static int _Console_ScanNumber(const char* text, size_t length, int* outInt, double* outDouble)
+{
+    /* every power of ten that is an exact double */
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    
+    const char* it = text;
+    const char* end = text + length;
+    int negative = 0;
+    
+    if (it < end && (*it == '-' || *it == '+'))
+    {
+        negative = *it == '-';
+        it++;
+    }
+    
+    if (end - it > 2 && it[0] == '0' && (it[1] == 'x' || it[1] == 'X'))
+    {
+        unsigned long long bits = 0;
+        
+        for (it += 2; it < end; it++)
+        {
+            int digit;
+            
+            if (*it >= '0' && *it <= '9')
+            {
+                digit = *it - '0';
+            }
+            else if (*it >= 'a' && *it <= 'f')
+            {
+                digit = *it - 'a' + 10;
+            }
+            else if (*it >= 'A' && *it <= 'F')
+            {
+                digit = *it - 'A' + 10;
+            }
+            else
+            {
+                return kConsoleNumberInvalid;
+            }
+            
+            bits = bits * 16 + (unsigned long long)digit;
+            
+            if (bits > 0xFFFFFFFFull)
+            {
+                return kConsoleNumberRange;
+            }
+        }
+        
+        unsigned int value = (unsigned int)bits;
+        *outInt = (int)(negative ? 0u - value : value);
+        return kConsoleNumberInt;
+    }
+    
+    const char* digitsStart = it;
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    /* digits beyond what mantissa holds were dropped */
+    int inexact = 0;
+    int isDouble = 0;
+    
+    for (; it < end && *it >= '0' && *it <= '9'; it++, digits++)
+    {
+        if (mantissa <= (~0ull - 9) / 10)
+        {
+            mantissa = mantissa * 10 + (unsigned long long)(*it - '0');
+        }
+        else
+        {
+            exponent++;
+            inexact = 1;
+        }
+    }
+    
+    if (it < end && *it == '.')
+    {
+        isDouble = 1;
+        
+        for (it++; it < end && *it >= '0' && *it <= '9'; it++, digits++)
+        {
+            if (mantissa <= (~0ull - 9) / 10)
+            {
+                mantissa = mantissa * 10 + (unsigned long long)(*it - '0');
+                exponent--;
+            }
+            else
+            {
+                inexact = 1;
+            }
+        }
+    }
+    
+    if (digits == 0)
+    {
+        return kConsoleNumberInvalid;
+    }
+    
+    const char* digitsEnd = it;
+    int written = 0;
+    
+    if (it < end && (*it == 'e' || *it == 'E'))
+    {
+        isDouble = 1;
+        it++;
+        
+        int exponentNegative = 0;
+        
+        if (it < end && (*it == '-' || *it == '+'))
+        {
+            exponentNegative = *it == '-';
+            it++;
+        }
+        
+        if (it == end)
+        {
+            return kConsoleNumberInvalid;
+        }
+        
+        for (; it < end && *it >= '0' && *it <= '9'; it++)
+        {
+            /* far past the double range either way */
+            if (written < 100000)
+            {
+                written = written * 10 + (*it - '0');
+            }
+        }
+        
+        written = exponentNegative ? -written : written;
+        exponent += written;
+    }
+    
+    if (it != end)
+    {
+        return kConsoleNumberInvalid;
+    }
+    
+    if (!isDouble)
+    {
+        if (inexact || mantissa > (negative ? 2147483648ull : 2147483647ull))
+        {
+            return kConsoleNumberRange;
+        }
+        
+        *outInt = (int)(negative ? -(long long)mantissa : (long long)mantissa);
+        return kConsoleNumberInt;
+    }
+    
+    double value;
+    
+    if (!inexact && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+    {
+        /* both operands are exact, so one correctly rounded operation */
+        value = (double)mantissa;
+        value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+    }
+    else
+    {
+        /* mantissa * 10^exponent is within a digit of the value, so it bounds the magnitude */
+        int magnitude = exponent;
+        for (unsigned long long rest = mantissa; rest > 0; rest /= 10)
+        {
+            magnitude++;
+        }
+        
+        if (mantissa != 0 && magnitude > 310)
+        {
+            return kConsoleNumberRange;
+        }
+        
+        if (mantissa == 0 || magnitude < -330)
+        {
+            value = 0.0;
+        }
+        else
+        {
+            /* rare, round exactly from an estimate a few units off */
+            double estimate = (double)mantissa * pow(10.0, exponent / 2) * pow(10.0, exponent - exponent / 2);
+            
+            if (!_Console_RoundDecimal(digitsStart, digitsEnd, written, estimate, &value))
+            {
+                return kConsoleNumberRange;
+            }
+        }
+    }
+    
+    *outDouble = negative ? -value : value;
+    return kConsoleNumberDouble;
+}
+
+/* log an error, prefixed with the script position when running one */
+static void _Console_Error(ConsoleRef console, const char* format, ...)
+{
+    va_list args;
+    
+    if (console->scriptName)
+    {
+        Console_Printf(console, "%s:%i: ", console->scriptName, console->scriptLine);
+    }
+    
+    va_start(args, format);
+    _Console_VPrintf(console, format, args);
+    va_end(args);
+}
+
+static void _ConsoleLexer_Init(struct ConsoleLexer* lexer, const char* name, const char* text, size_t length)
+{
+    lexer->name = name;
+    lexer->it = text;
+    lexer->end = text + length;
+    lexer->line = 1;
+    lexer->statementLine = 1;
+}
+
+static void _ConsoleLexer_Error(ConsoleRef console, const struct ConsoleLexer* lexer, const char* message)
+{
+    if (lexer->name)
+    {
+        Console_Printf(console, "%s:%i: ", lexer->name, lexer->statementLine);
+    }
+    
+    Console_Printf(console, "%s\n", message);
+}
+
+/*
+ read the tokens of the next statement, in place.
+ statements end at new lines and ';' outside of quotes.
+ '#' and '//' at the start of a token comment out the rest of the line.
+ returns the token count, 0 at the end of the text or -1 on error
+ */
+static int _ConsoleLexer_Next(ConsoleRef console,
+                              struct ConsoleLexer* lexer,
+                              struct ConsoleToken* outTokens,
+                              int maxTokens)
+{
+    int tokenCount = 0;
+    
+    const char* it = lexer->it;
+    const char* end = lexer->end;
+    
+    while (it < end)
+    {
+        char c = *it;
+        
+        if (c == '\n' || c == ';')
+        {
+            it++;
+            
+            if (c == '\n')
+            {
+                lexer->line++;
+            }
+            
+            if (tokenCount > 0)
+            {
+                break;
+            }
+            
+            continue;
+        }
+        
+        if (isspace((unsigned char)c))
+        {
+            it++;
+            continue;
+        }
+        
+        if (c == '#' || (c == '/' && it + 1 < end && it[1] == '/'))
+        {
+            while (it < end && *it != '\n')
+            {
+                it++;
+            }
+            
+            continue;
+        }
+        
+        if (tokenCount == 0)
+        {
+            lexer->statementLine = lexer->line;
+        }
+        
+        struct ConsoleToken token;
+        token.text = it;
+        
+        if (c == '\"')
+        {
+            /* keep the opening quote, literals use it to tell strings apart */
+            it++;
+            
+            while (it < end && *it != '\"')
+            {
+                if (*it == '\n')
+                {
+                    lexer->line++;
+                }
+                
+                it++;
+            }
+            
+            token.length = (size_t)(it - token.text);
+            
+            if (it < end)
+            {
+                it++;
+            }
+            else
+            {
+                _ConsoleLexer_Error(console, lexer, "trailing quote");
+            }
+        }
+        else
+        {
+            while (it < end && !isspace((unsigned char)*it) && *it != ';')
+            {
+                it++;
+            }
+            
+            token.length = (size_t)(it - token.text);
+        }
+        
+        /* count the rest so the whole statement is skipped */
+        if (tokenCount < maxTokens)
+        {
+            outTokens[tokenCount] = token;
+        }
+        
+        tokenCount++;
+    }
+    
+    lexer->it = it;
+    
+    if (tokenCount > maxTokens)
+    {
+        _ConsoleLexer_Error(console, lexer, "too many tokens");
+        return -1;
+    }
+    
+    return tokenCount;
+}
+
+/* for calls taking one statement, reports any that follow - returns 1 if none do */
+static int _ConsoleLexer_ExpectEnd(ConsoleRef console, const struct ConsoleLexer* lexer, const char* caller)
+{
+    struct ConsoleLexer rest = *lexer;
+    struct ConsoleToken tokens[CONSOLE_MAX_TOKENS];
+    int tokenCount = _ConsoleLexer_Next(console, &rest, tokens, CONSOLE_MAX_TOKENS);
+    
+    if (tokenCount > 0)
+    {
+        Console_Printf(console, "%s: takes one statement, scripts take more\n", caller);
+    }
+    
+    return tokenCount == 0;
+}
+
+/* parse a literal token, returns success */
+static int _Console_BindLiteral(ConsoleRef console,
+                                struct ConsoleArena* arena,
+                                struct ConsoleToken literal,
+                                ConsoleArgView_t* view)
+{
+    view->var = NULL;
+    
+    int intValue = 0;
+    double doubleValue = 0.0;
+    int number = _Console_ScanNumber(literal.text, literal.length, &intValue, &doubleValue);
+    
+    switch (number)
+    {
+        case kConsoleNumberInt:
+            view->type = kConsoleVarTypeInt;
+            view->value.intValue = intValue;
+            return 1;
+        case kConsoleNumberDouble:
+            view->type = kConsoleVarTypeDouble;
+            view->value.doubleValue = doubleValue;
+            return 1;
+        case kConsoleNumberRange:
+            _Console_Error(console, "number out of range: %.*s\n", (int)literal.length, literal.text);
+            return 0;
+        default:
+            break;
+    }
+    
+    /* string, '-' also starts one when no number follows */
+    if (*literal.text == '\"' || *literal.text == '-')
+    {
+        size_t length = literal.length - 1;
+        char* string = _ConsoleArena_Alloc(arena, length + 1);
+        
+        if (!string)
+        {
+            return 0;
+        }
+        
+        memcpy(string, literal.text + 1, length);
+        string[length] = '\0';
+        
+        view->type = kConsoleVarTypeString;
+        view->value.stringValue = string;
+        return 1;
+    }
+    
+    _Console_Error(console, "unknown symbol: \"%.*s\"\n", (int)literal.length, literal.text);
+    return 0;
+}
+
+/* read a var argument converted to the type its view was checked against */
+static void _ConsoleArgView_LoadTyped(ConsoleArgView_t* view)
+{
+    ConsoleVarRef var = view->var;
+    
+    switch (view->type)
+    {
+        case kConsoleVarTypeDouble:
+            view->value.doubleValue = ConsoleVar_DoubleValue(var);
+            break;
+        case kConsoleVarTypeInt:
+            view->value.intValue = ConsoleVar_IntValue(var);
+            break;
+        case kConsoleVarTypeBool:
+            view->value.intValue = ConsoleVar_IntValue(var) != 0;
+            break;
+        case kConsoleVarTypeString:
+            view->value.stringValue = ConsoleVar_StringValue(var);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ check an argument against a signature type. literals are converted
+ in place, vars are converted each time they are loaded.
+ returns 0 on a mismatch
+ */
+static int _ConsoleArgView_Convert(ConsoleArgView_t* view, ConsoleVarType_t type)
+{
+    ConsoleVarType_t sourceType = view->var ? (ConsoleVarType_t)view->var->type : view->type;
+    
+    if ((sourceType == kConsoleVarTypeString) != (type == kConsoleVarTypeString))
+    {
+        return 0;
+    }
+    
+    /* no silent truncation, only whole number literals pass as ints */
+    if (sourceType == kConsoleVarTypeDouble && (type == kConsoleVarTypeInt || type == kConsoleVarTypeBool))
+    {
+        if (view->var)
+        {
+            return 0;
+        }
+        
+        double value = view->value.doubleValue;
+        
+        if (!(value >= -2147483648.0 && value <= 2147483647.0) || value != (double)(int)value)
+        {
+            return 0;
+        }
+    }
+    
+    if (!view->var && type != kConsoleVarTypeString)
+    {
+        if (type == kConsoleVarTypeDouble)
+        {
+            if (sourceType != kConsoleVarTypeDouble)
+            {
+                view->value.doubleValue = (double)view->value.intValue;
+            }
+        }
+        else
+        {
+            int intValue = (sourceType == kConsoleVarTypeDouble) ? (int)view->value.doubleValue : view->value.intValue;
+            view->value.intValue = (type == kConsoleVarTypeBool) ? intValue != 0 : intValue;
+        }
+    }
+    
+    view->type = type;
+    return 1;
+}
+
+/* apply a typed command's signature to bound arguments, returns success */
+static int _Console_CheckSignature(ConsoleRef console, struct ConsoleStatement* statement)
+{
+    ConsoleCommandRef command = statement->command;
+    
+    static const char* typeNames[] = { "double", "string", "int", "bool" };
+    
+    /* count mismatches are reported at dispatch */
+    int i;
+    for (i = 0; i < statement->argCount && i < command->argCount; i++)
+    {
+        ConsoleVarType_t type;
+        
+        /* registration rejects other characters */
+        if (!_Console_SignatureType(command->signature[i], &type))
+        {
+            return 0;
+        }
+        
+        if (!_ConsoleArgView_Convert(&statement->views[i], type))
+        {
+            _Console_Error(console, "%s: argument %i should be %s\n", command->name, i + 1, typeNames[type]);
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+/*
+ build the linked list ConsoleFunc_t commands expect.
+ literals become readonly temp vars - returns success
+ */
+static int _Console_BindArgChain(struct ConsoleArena* arena, struct ConsoleStatement* statement)
+{
+    statement->args = _ConsoleArena_Alloc(arena, sizeof(struct ConsoleArg) * statement->argCount);
+    
+    if (!statement->args)
+    {
+        return 0;
+    }
+    
+    int i;
+    for (i = 0; i < statement->argCount; i++)
+    {
+        const ConsoleArgView_t* view = &statement->views[i];
+        ConsoleVarRef argVar = view->var;
+        
+        if (!argVar)
+        {
+            if (view->type == kConsoleVarTypeString)
+            {
+                argVar = _Console_CreateTempString(arena, view->value.stringValue);
+            }
+            else
+            {
+                argVar = _Console_CreateTempVar(arena, view->type);
+                
+                if (argVar && view->type == kConsoleVarTypeDouble)
+                {
+                    argVar->value.doubleValue = view->value.doubleValue;
+                }
+                else if (argVar)
+                {
+                    argVar->value.intValue = view->value.intValue;
+                }
+            }
+            
+            if (!argVar)
+            {
+                return 0;
+            }
+        }
+        
+        statement->args[i].var = argVar;
+        statement->args[i].next = (i + 1 < statement->argCount) ? &statement->args[i + 1] : NULL;
+    }
+    
+    return 1;
+}
+
+/*
+ resolve a tokenized command into statement, allocating
+ literals from arena. returns success
+ */
+static int _Console_Bind(ConsoleRef console,
+                         struct ConsoleArena* arena,
+                         const struct ConsoleToken* tokens,
+                         int tokenCount,
+                         struct ConsoleStatement* statement)
+{
+    ConsoleCommandRef command = _ConsoleIndex_FindToken(&console->commandIndex, tokens[0], _Console_HashToken(tokens[0]));
+    
+    if (!command)
+    {
+        _Console_Error(console, "unknown command: %.*s\n", (int)tokens[0].length, tokens[0].text);
+        return 0;
+    }
+    
+    int argCount = tokenCount - 1;
+    
+    statement->command = command;
+    statement->argCount = argCount;
+    statement->views = NULL;
+    statement->args = NULL;
+    statement->generation = console->symbolGeneration;
+    
+    if (argCount == 0)
+    {
+        return 1;
+    }
+    
+    statement->views = _ConsoleArena_Alloc(arena, sizeof(ConsoleArgView_t) * argCount);
+    
+    if (!statement->views)
+    {
+        return 0;
+    }
+    
+    int i;
+    for (i = 0; i < argCount; i++)
+    {
+        struct ConsoleToken argToken = tokens[i + 1];
+        ConsoleArgView_t* view = &statement->views[i];
+        
+        ConsoleVarRef var = NULL;
+        
+        /* quoted strings are never vars */
+        if (*argToken.text != '\"')
+        {
+            var = _ConsoleIndex_FindToken(&console->varIndex, argToken, _Console_HashToken(argToken));
+        }
+        
+        if (var)
+        {
+            view->var = var;
+            view->type = (ConsoleVarType_t)var->type;
+        }
+        else if (!_Console_BindLiteral(console, arena, argToken, view))
+        {
+            return 0;
+        }
+    }
+    
+    if (command->func)
+    {
+        return _Console_BindArgChain(arena, statement);
+    }
+    
+    if (command->signature)
+    {
+        return _Console_CheckSignature(console, statement);
+    }
+    
+    return 1;
+}
+
+/*
+ refresh a statement after registrations shadowed names it uses.
+ returns success
+ */
+static int _Console_Rebind(ConsoleRef console, struct ConsoleArena* arena, struct ConsoleStatement* statement)
+{
+    ConsoleCommandRef command = _Console_FindCommand(console, statement->command->name);
+    
+    if (!command)
+    {
+        return 0;
+    }
+    
+    statement->command = command;
+    
+    int i;
+    for (i = 0; i < statement->argCount; i++)
+    {
+        ConsoleArgView_t* view = &statement->views[i];
+        
+        if (view->var)
+        {
+            ConsoleVarRef var = Console_FindVar(console, view->var->name);
+            
+            if (!var)
+            {
+                return 0;
+            }
+            
+            view->var = var;
+            
+            if (statement->args)
+            {
+                statement->args[i].var = var;
+            }
+        }
+    }
+    
+    /* the command may have been replaced by a linked list one */
+    if (command->func && !statement->args && statement->argCount > 0)
+    {
+        if (!_Console_BindArgChain(arena, statement))
+        {
+            return 0;
+        }
+    }
+    
+    /* or by one with a different signature, or vars by other types */
+    if (command->signature && !_Console_CheckSignature(console, statement))
+    {
+        return 0;
+    }
+    
+    statement->generation = console->symbolGeneration;
+    return 1;
+}
+
+/* returns whether the command succeeded */
+static int _Console_Dispatch(ConsoleRef console, const struct ConsoleStatement* statement)
+{
+    ConsoleCommandRef command = statement->command;
+    
+    int fail = 0;
+    if (command->argCount >= 0)
+    {
+        if (command->argCount != statement->argCount)
+        {
+            _Console_Error(console, "%s: expected %i arguments\n", command->name, command->argCount);
+            fail = 1;
+        }
+    }
+    
+    if (!fail)
+    {
+        if (command->argvFunc)
+        {
+            int i;
+            for (i = 0; i < statement->argCount; i++)
+            {
+                if (!statement->views[i].var)
+                {
+                    continue;
+                }
+                
+                if (command->signature)
+                {
+                    _ConsoleArgView_LoadTyped(&statement->views[i]);
+                }
+                else
+                {
+                    _ConsoleArgView_Load(&statement->views[i]);
+                }
+            }
+            
+#ifdef CONSOLE_PROFILE
+            long long start = _Console_Now();
+#endif
+            console->executeDepth++;
+            fail = !command->argvFunc(console, statement->argCount, statement->views);
+            console->executeDepth--;
+#ifdef CONSOLE_PROFILE
+            _ConsoleHistogram_Add(&command->stats.handler, _Console_Now() - start);
+#endif
+        }
+        else
+        {
+#ifdef CONSOLE_PROFILE
+            long long start = _Console_Now();
+#endif
+            console->executeDepth++;
+            fail = !command->func(console, statement->args);
+            console->executeDepth--;
+#ifdef CONSOLE_PROFILE
+            _ConsoleHistogram_Add(&command->stats.handler, _Console_Now() - start);
+#endif
+        }
+    }
+    
+#ifdef CONSOLE_PROFILE
+    command->stats.calls++;
+    command->stats.failures += (unsigned long long)fail;
+#endif
+    
+    if (fail)
+    {
+        _Console_Error(console, "%s failed\n", command->name);
+    }
+    
+    return !fail;
+}
+
+/* bind and dispatch one statement, returns success of both */
+static int _Console_ExecuteTokens(ConsoleRef console, const struct ConsoleToken* tokens, int tokenCount, int* outBound)
+{
+    /* arguments are carved from the arena and released at the end */
+    struct ConsoleArenaMark mark = _ConsoleArena_Mark(&console->arena);
+    
+    /* spans are named by the command as typed */
+    int traced = console->trace && _ConsoleTrace_Begin(console->trace, tokens[0].text, tokens[0].length);
+    
+#ifdef CONSOLE_PROFILE
+    long long parsed = _Console_Now();
+#endif
+    
+    struct ConsoleStatement statement;
+    statement.command = NULL;
+    int success = _Console_Bind(console, &console->arena, tokens, tokenCount, &statement);
+    
+#ifdef CONSOLE_PROFILE
+    /* unknown commands have nowhere to record */
+    if (statement.command)
+    {
+        ConsoleCommandStats_t* stats = &statement.command->stats;
+        _ConsoleHistogram_Add(&stats->parse, parsed - console->parseStart);
+        _ConsoleHistogram_Add(&stats->lookup, _Console_Now() - parsed);
+        
+        if (!success)
+        {
+            stats->calls++;
+            stats->failures++;
+        }
+    }
+#endif
+    
+    if (outBound)
+    {
+        *outBound = success;
+    }
+    
+    if (success)
+    {
+        success = _Console_Dispatch(console, &statement);
+    }
+    
+    _ConsoleArena_Reset(&console->arena, mark);
+    _Console_TraceEnd(console, traced);
+    
+    return success;
+}
+
+int Console_Execute(ConsoleRef console, const char* command)
+{
+    assert(console);
+    assert(command);
+    
+    struct ConsoleLexer lexer;
+    _ConsoleLexer_Init(&lexer, NULL, command, strlen(command));
+    
+#ifdef CONSOLE_PROFILE
+    console->parseStart = _Console_Now();
+#endif
+    
+    struct ConsoleToken tokens[CONSOLE_MAX_TOKENS];
+    int tokenCount = _ConsoleLexer_Next(console, &lexer, tokens, CONSOLE_MAX_TOKENS);
+    
+    if (tokenCount < 0)
+    {
+        return 0;
+    }
+    
+    if (tokenCount == 0)
+    {
+        Console_Printf(console, "nothing to execute\n");
+        return 0;
+    }
+    
+    if (!_ConsoleLexer_ExpectEnd(console, &lexer, "execute"))
+    {
+        return 0;
+    }
+    
+    if (console->recorder)
+    {
+        _Console_Record(console, tokens[0].text, (size_t)(lexer.it - tokens[0].text));
+    }
+    
+    /* as before scripts, commands that run succeed even if they fail */
+    int bound;
+    _Console_ExecuteTokens(console, tokens, tokenCount, &bound);
+    return bound;
+}
+
+/* execute every statement, continuing past errors - returns success */
+static int _Console_RunScript(ConsoleRef console, const char* name, const char* script, size_t length)
+{
+    /* scripts may execute scripts */
+    const char* outerName = console->scriptName;
+    int outerLine = console->scriptLine;
+    
+    console->scriptName = name;
+    int traced = _Console_TraceBegin(console, name);
+    
+    struct ConsoleLexer lexer;
+    _ConsoleLexer_Init(&lexer, name, script, length);
+    
+    struct ConsoleToken tokens[CONSOLE_MAX_TOKENS];
+    int success = 1;
+    
+    for (;;)
+    {
+#ifdef CONSOLE_PROFILE
+        console->parseStart = _Console_Now();
+#endif
+        int tokenCount = _ConsoleLexer_Next(console, &lexer, tokens, CONSOLE_MAX_TOKENS);
+        
+        if (tokenCount == 0)
+        {
+            break;
+        }
+        
+        console->scriptLine = lexer.statementLine;
+        
+        if (tokenCount > 0 && console->recorder)
+        {
+            _Console_Record(console, tokens[0].text, (size_t)(lexer.it - tokens[0].text));
+        }
+        
+        if (tokenCount < 0 || !_Console_ExecuteTokens(console, tokens, tokenCount, NULL))
+        {
+            success = 0;
+        }
+        
+        if (console->waitFrames > 0)
+        {
+            unsigned int frame = console->frame + (unsigned int)console->waitFrames;
+            size_t remaining = length - (size_t)(lexer.it - script);
+            console->waitFrames = 0;
+            
+            if (remaining > 0 && !_Console_Schedule(console, lexer.it, remaining, frame))
+            {
+                success = 0;
+            }
+            
+            break;
+        }
+    }
+    
+    _Console_TraceEnd(console, traced);
+    console->scriptName = outerName;
+    console->scriptLine = outerLine;
+    
+    return success;
+}
+
+int Console_ExecuteScript(ConsoleRef console, const char* script, size_t length)
+{
+    assert(console);
+    assert(script || length == 0);
+    
+    return _Console_RunScript(console, "script", script, length);
+}
+
+int Console_ExecuteFile(ConsoleRef console, const char* path)
+{
+    assert(console);
+    assert(path);
+    
+    size_t size = 0;
+    const void* data = _Console_MapFile(path, &size);
+    
+    if (!data)
+    {
+        /* empty files have nothing to map */
+        FILE* file = fopen(path, "r");
+        
+        if (file)
+        {
+            fclose(file);
+            return 1;
+        }
+        
+        Console_Printf(console, "can't read %s\n", path);
+        return 0;
+    }
+    
+    int success = _Console_RunScript(console, path, data, size);
+    _Console_UnmapFile(data, size);
+    return success;
+}
+
+ConsoleCompiledRef Console_Compile(ConsoleRef console, const char* command)
+{
+    assert(console);
+    assert(command);
+    
+    struct ConsoleLexer lexer;
+    _ConsoleLexer_Init(&lexer, NULL, command, strlen(command));
+    
+    struct ConsoleToken tokens[CONSOLE_MAX_TOKENS];
+    int tokenCount = _ConsoleLexer_Next(console, &lexer, tokens, CONSOLE_MAX_TOKENS);
+    
+    if (tokenCount < 0)
+    {
+        return NULL;
+    }
+    
+    if (tokenCount == 0)
+    {
+        Console_Printf(console, "nothing to compile\n");
+        return NULL;
+    }
+    
+    if (!_ConsoleLexer_ExpectEnd(console, &lexer, "compile"))
+    {
+        return NULL;
+    }
+    
+    ConsoleCompiledRef compiled = _Console_Malloc(sizeof(struct ConsoleCompiled));
+    
+    if (!compiled)
+    {
+        return NULL;
+    }
+    
+    if (!_ConsoleArena_Init(&compiled->arena, CONSOLE_COMPILED_CHUNK_SIZE))
+    {
+        _Console_Free(compiled);
+        return NULL;
+    }
+    
+    compiled->sourceLength = (size_t)(lexer.it - tokens[0].text);
+    char* source = _ConsoleArena_Alloc(&compiled->arena, compiled->sourceLength);
+    
+    if (!source || !_Console_Bind(console, &compiled->arena, tokens, tokenCount, &compiled->statement))
+    {
+        _ConsoleArena_Shutdown(&compiled->arena);
+        _Console_Free(compiled);
+        return NULL;
+    }
+    
+    memcpy(source, tokens[0].text, compiled->sourceLength);
+    compiled->source = source;
+    
+    compiled->console = console;
+    compiled->prev = NULL;
+    compiled->next = console->compiled;
+    
+    if (console->compiled)
+    {
+        console->compiled->prev = compiled;
+    }
+    
+    console->compiled = compiled;
+    
+    return compiled;
+}
+
+int Console_Run(ConsoleCompiledRef compiled)
+{
+    assert(compiled);
+    
+    ConsoleRef console = compiled->console;
+    struct ConsoleStatement* statement = &compiled->statement;
+    
+    /* compiled commands skip parsing and lookup, only the handler is timed */
+    if (statement->generation != console->symbolGeneration)
+    {
+        if (!_Console_Rebind(console, &compiled->arena, statement))
+        {
+            return 0;
+        }
+    }
+    
+    if (console->recorder)
+    {
+        _Console_Record(console, compiled->source, compiled->sourceLength);
+    }
+    
+    int traced = _Console_TraceBegin(console, statement->command->name);
+    _Console_Dispatch(console, statement);
+    _Console_TraceEnd(console, traced);
+    return 1;
+}
+
+void Console_ReleaseCompiled(ConsoleCompiledRef compiled)
+{
+    if (compiled)
+    {
+        ConsoleRef console = compiled->console;
+        
+        if (compiled->prev)
+        {
+            compiled->prev->next = compiled->next;
+        }
+        else
+        {
+            console->compiled = compiled->next;
+        }
+        
+        if (compiled->next)
+        {
+            compiled->next->prev = compiled->prev;
+        }
+        
+        _ConsoleArena_Shutdown(&compiled->arena);
+        _Console_Free(compiled);
+    }
+}
+
+int Console_BindKey(ConsoleRef console, int key, const char* command)
+{
+    assert(console);
+    assert(command);
+    
+    if (key < 0 || key >= CONSOLE_KEY_MAX)
+    {
+        return 0;
+    }
+    
+    if (key >= console->bindingCount)
+    {
+        struct ConsoleKeyBinding* bindings = _Console_ReserveArray(console->bindings, sizeof(struct ConsoleKeyBinding), console->bindingCount, &console->bindingCapacity, key + 1);
+        
+        if (!bindings)
+        {
+            return 0;
+        }
+        
+        memset(bindings + console->bindingCount, 0, sizeof(struct ConsoleKeyBinding) * (size_t)(key + 1 - console->bindingCount));
+        console->bindings = bindings;
+        console->bindingCount = key + 1;
+    }
+    
+    ConsoleCompiledRef down = Console_Compile(console, command);
+    
+    if (!down)
+    {
+        return 0;
+    }
+    
+    /* saved without a trailing ';' */
+    size_t length = down->sourceLength;
+    while (length > 0 && (isspace((unsigned char)down->source[length - 1]) || down->source[length - 1] == ';'))
+    {
+        length--;
+    }
+    
+    char* text = _Console_Malloc(length + 1);
+    
+    if (!text)
+    {
+        Console_ReleaseCompiled(down);
+        return 0;
+    }
+    
+    memcpy(text, down->source, length);
+    text[length] = '\0';
+    
+    /* +name pairs with -name, which gets no arguments */
+    ConsoleCompiledRef up = NULL;
+    const char* name = down->statement.command->name;
+    
+    if (name[0] == '+')
+    {
+        /* names have no length limit, so the arena holds it briefly */
+        struct ConsoleArenaMark mark = _ConsoleArena_Mark(&console->arena);
+        size_t nameLength = strlen(name);
+        char* releaseName = _ConsoleArena_Alloc(&console->arena, nameLength + 1);
+        
+        if (releaseName)
+        {
+            memcpy(releaseName, name, nameLength + 1);
+            releaseName[0] = '-';
+            
+            if (_Console_FindCommand(console, releaseName))
+            {
+                up = Console_Compile(console, releaseName);
+            }
+        }
+        
+        _ConsoleArena_Reset(&console->arena, mark);
+    }
+    
+    Console_UnbindKey(console, key);
+    
+    struct ConsoleKeyBinding* binding = &console->bindings[key];
+    binding->command = text;
+    binding->down = down;
+    binding->up = up;
+    
+    return 1;
+}
+
+void Console_UnbindKey(ConsoleRef console, int key)
+{
+    assert(console);
+    
+    if (key < 0 || key >= console->bindingCount)
+    {
+        return;
+    }
+    
+    struct ConsoleKeyBinding* binding = &console->bindings[key];
+    
+    Console_ReleaseCompiled(binding->down);
+    Console_ReleaseCompiled(binding->up);
+    _Console_Free(binding->command);
+    
+    binding->command = NULL;
+    binding->down = NULL;
+    binding->up = NULL;
+}
+
+const char* Console_KeyBinding(ConsoleRef console, int key)
+{
+    assert(console);
+    
+    if (key < 0 || key >= console->bindingCount)
+    {
+        return NULL;
+    }
+    
+    return console->bindings[key].command;
+}
+
+int Console_KeyEvent(ConsoleRef console, int key, int down)
+{
+    assert(console);
+    
+    if (key < 0 || key >= console->bindingCount)
+    {
+        return 0;
+    }
+    
+    ConsoleCompiledRef compiled = down ? console->bindings[key].down : console->bindings[key].up;
+    
+    if (!compiled)
+    {
+        return 0;
+    }
+    
+    /* may rebind this key, nothing is read after */
+    return Console_Run(compiled);
+}
+
+static int _ConsoleRecorder_Flush(struct ConsoleRecorder* recorder)
+{
+    if (recorder->used > 0 && fwrite(recorder->buffer, 1, recorder->used, recorder->file) != recorder->used)
+    {
+        recorder->failed = 1;
+    }
+    
+    recorder->used = 0;
+    return !recorder->failed;
+}
+
+static void _ConsoleRecorder_Write(struct ConsoleRecorder* recorder, const void* data, size_t size)
+{
+    if (CONSOLE_RECORD_BUFFER_SIZE - recorder->used < size)
+    {
+        _ConsoleRecorder_Flush(recorder);
+        
+        /* too big to buffer */
+        if (size > CONSOLE_RECORD_BUFFER_SIZE)
+        {
+            if (fwrite(data, 1, size, recorder->file) != size)
+            {
+                recorder->failed = 1;
+            }
+            
+            return;
+        }
+    }
+    
+    memcpy(recorder->buffer + recorder->used, data, size);
+    recorder->used += size;
+}
+
+/* LEB128, at most 10 bytes - returns bytes written */
+static size_t _Console_PutVarint(unsigned char* out, unsigned long long value)
+{
+    size_t length = 0;
+    
+    while (value >= 0x80)
+    {
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+/* returns 0 if the data ends first or the value is too long */
+static int _Console_GetVarint(const unsigned char* data, size_t size, size_t* offset, unsigned long long* outValue)
+{
+    unsigned long long value = 0;
+    int shift = 0;
+    
+    while (*offset < size && shift < 64)
+    {
+        unsigned char byte = data[(*offset)++];
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        
+        if (!(byte & 0x80))
+        {
+            *outValue = value;
+            return 1;
+        }
+        
+        shift += 7;
+    }
+    
+    return 0;
+}
+
+/* record a command reaching the console, nested commands replay themselves */
+static void _Console_Record(ConsoleRef console, const char* text, size_t length)
+{
+    struct ConsoleRecorder* recorder = console->recorder;
+    
+    if (!recorder || console->executeDepth > 0 || recorder->failed)
+    {
+        return;
+    }
+    
+    /* trailing separators and space aren't part of the command */
+    while (length > 0 && (isspace((unsigned char)text[length - 1]) || text[length - 1] == ';'))
+    {
+        length--;
+    }
+    
+    struct ConsoleToken span;
+    span.text = text;
+    span.length = length;
+    unsigned int hash = _Console_HashToken(span);
+    
+    void* found = _ConsoleIndex_FindToken(&recorder->strings, span, hash);
+    unsigned int id;
+    int isNew = 0;
+    
+    if (found)
+    {
+        id = (unsigned int)((uintptr_t)found - 1);
+    }
+    else
+    {
+        char* copy = _ConsoleArena_Alloc(&recorder->stringArena, length + 1);
+        
+        if (!copy || !_ConsoleIndex_Reserve(&recorder->strings, recorder->stringCount + 1))
+        {
+            recorder->failed = 1;
+            return;
+        }
+        
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+        
+        id = recorder->stringCount++;
+        _ConsoleIndex_Insert(&recorder->strings, copy, hash, (void*)(uintptr_t)(id + 1));
+        isNew = 1;
+    }
+    
+    unsigned char header[30];
+    size_t headerLength = _Console_PutVarint(header, console->frame - recorder->lastFrame);
+    headerLength += _Console_PutVarint(header + headerLength, id);
+    recorder->lastFrame = console->frame;
+    
+    if (isNew)
+    {
+        headerLength += _Console_PutVarint(header + headerLength, length);
+    }
+    
+    _ConsoleRecorder_Write(recorder, header, headerLength);
+    
+    if (isNew)
+    {
+        _ConsoleRecorder_Write(recorder, text, length);
+    }
+}
+
+/* record a var set without a command, by load or snapshot */
+static void _Console_RecordVar(ConsoleRef console, ConsoleVarRef var)
+{
+    if (!console->recorder || console->executeDepth > 0)
+    {
+        return;
+    }
+    
+    char number[CONSOLE_NUMBER_STRING_MAX];
+    const char* value = number;
+    
+    switch (var->type)
+    {
+        case kConsoleVarTypeString:
+            value = ConsoleVar_StringValue(var);
+            break;
+        case kConsoleVarTypeDouble:
+            Console_FormatDouble(ConsoleVar_DoubleValue(var), number);
+            break;
+        default:
+            Console_FormatInt(ConsoleVar_IntValue(var), number);
+            break;
+    }
     
-    switch (var->type)
+    /* the lexer has no escapes, so quoted values can't hold quotes */
+    int opaque = var->type == kConsoleVarTypeString && strchr(value, '\"') != NULL;
+    
+    /* set name value, or set name "value" */
+    size_t nameLength = strlen(var->name);
+    size_t valueLength = strlen(value);
+    size_t length = 4 + nameLength + 1 + valueLength + 2;
+    
+    char stackCommand[CONSOLE_PRINT_BUFFER_SIZE];
+    char* command = length <= sizeof(stackCommand) ? stackCommand : _Console_Malloc(length);
+    
+    if (!command)
     {
-        case kConsoleVarTypeDouble:
-            return var->doubleValue;
-        case kConsoleVarTypeInt:
-            return var->doubleValue;
-        case kConsoleVarTypeBool:
-            return var->doubleValue;
-        case kConsoleVarTypeString:
+        console->recorder->failed = 1;
+        return;
+    }
+    
+    char* it = command;
+    
+    if (opaque)
+    {
+        *it++ = CONSOLE_RECORD_SET_STRING;
+        memcpy(it, var->name, nameLength + 1);
+        it += nameLength + 1;
+        memcpy(it, value, valueLength + 1);
+        it += valueLength + 1;
+    }
+    else
+    {
+        memcpy(it, "set ", 4);
+        it += 4;
+        memcpy(it, var->name, nameLength);
+        it += nameLength;
+        *it++ = ' ';
+        
+        if (var->type == kConsoleVarTypeString)
         {
-            double val = 0.0;
-            sscanf(var->stringValue, "%lf", &val);
-            return val;
+            *it++ = '\"';
+        }
+        
+        memcpy(it, value, valueLength);
+        it += valueLength;
+        
+        if (var->type == kConsoleVarTypeString)
+        {
+            *it++ = '\"';
         }
-        default:
-            break;
     }
     
-    return var->doubleValue;
-}
-
-void ConsoleVar_SetIntValue(ConsoleVarRef var, int value)
-{
-    assert(var);
-    assert(var->type == kConsoleVarTypeInt ||
-           var->type == kConsoleVarTypeBool);
+    _Console_Record(console, command, (size_t)(it - command));
     
-    var->intValue = value;
-    var->doubleValue = (double)value;
+    if (command != stackCommand)
+    {
+        _Console_Free(command);
+    }
 }
 
-int ConsoleVar_IntValue(ConsoleVarRef var)
+int Console_StartRecording(ConsoleRef console, FILE* outFile)
 {
-    assert(var);
+    assert(console);
+    assert(outFile);
     
-    switch (var->type)
+    if (console->recorder)
     {
-        case kConsoleVarTypeDouble:
-            return var->intValue;
-        case kConsoleVarTypeInt:
-            return var->intValue;
-        case kConsoleVarTypeBool:
-            return var->intValue;
-        case kConsoleVarTypeString:
-        {
-            int val = 0.0;
-            sscanf(var->stringValue, "%d", &val);
-            return val;
-        }
-        default:
-            break;
+        Console_StopRecording(console);
+    }
+    
+    struct ConsoleRecorder* recorder = _Console_Malloc(sizeof(struct ConsoleRecorder));
+    
+    if (!recorder)
+    {
+        return 0;
+    }
+    
+    recorder->buffer = _Console_Malloc(CONSOLE_RECORD_BUFFER_SIZE);
+    
+    if (!recorder->buffer || !_ConsoleArena_Init(&recorder->stringArena, CONSOLE_ARENA_CHUNK_SIZE))
+    {
+        _Console_Free(recorder->buffer);
+        _Console_Free(recorder);
+        return 0;
     }
+    
+    _ConsoleIndex_Init(&recorder->strings);
+    recorder->file = outFile;
+    recorder->used = 0;
+    recorder->failed = 0;
+    recorder->stringCount = 0;
+    recorder->lastFrame = 0;
+    
+    static const unsigned char header[8] = { 'C', 'R', 'E', 'C', CONSOLE_RECORD_VERSION, 0, 0, 0 };
+    _ConsoleRecorder_Write(recorder, header, sizeof(header));
+    
+    console->recorder = recorder;
+    return 1;
 }
 
-void ConsoleVar_SetBoolValue(ConsoleVarRef var, int value)
+int Console_StopRecording(ConsoleRef console)
 {
-    ConsoleVar_SetIntValue(var, value);
+    assert(console);
+    
+    struct ConsoleRecorder* recorder = console->recorder;
+    
+    if (!recorder)
+    {
+        return 0;
+    }
+    
+    int success = _ConsoleRecorder_Flush(recorder) && fflush(recorder->file) == 0;
+    
+    _ConsoleIndex_Shutdown(&recorder->strings);
+    _ConsoleArena_Shutdown(&recorder->stringArena);
+    _Console_Free(recorder->buffer);
+    _Console_Free(recorder);
+    console->recorder = NULL;
+    
+    return success;
 }
 
-int ConsoleVar_BoolValue(ConsoleVarRef var)
+void Console_SetFrame(ConsoleRef console, unsigned int frame)
 {
-    return ConsoleVar_IntValue(var);
+    assert(console);
+    assert(frame >= console->frame);
+    console->frame = frame;
 }
 
-
-void ConsoleVar_SetStringValue(ConsoleVarRef var, const char* string)
+unsigned int Console_Frame(ConsoleRef console)
 {
-    assert(var);
-    strcpy(var->stringValue, string);
+    assert(console);
+    return console->frame;
 }
 
-const char* ConsoleVar_StringValue(ConsoleVarRef var)
+static void _ConsoleTimerWheel_Link(struct ConsoleTimerWheel* wheel, int index, int list)
 {
-    assert(var);
-    return var->stringValue;
+    struct ConsoleTimer* timer = &wheel->timers[index];
+    timer->list = list;
+    timer->prev = -1;
+    timer->next = wheel->heads[list];
+    
+    if (timer->next >= 0)
+    {
+        wheel->timers[timer->next].prev = index;
+    }
+    
+    wheel->heads[list] = index;
 }
 
-static ConsoleCommandRef _ConsoleCommand_Create()
+static void _ConsoleTimerWheel_Unlink(struct ConsoleTimerWheel* wheel, int index)
 {
-    ConsoleCommandRef command = _Console_Malloc(sizeof(struct ConsoleCommand));
+    struct ConsoleTimer* timer = &wheel->timers[index];
     
-    if (command)
+    if (timer->prev >= 0)
     {
-        command->func = NULL;
-        command->argCount = -1;
+        wheel->timers[timer->prev].next = timer->next;
+    }
+    else
+    {
+        wheel->heads[timer->list] = timer->next;
     }
     
-    return command;
+    if (timer->next >= 0)
+    {
+        wheel->timers[timer->next].prev = timer->prev;
+    }
 }
 
-/* lists all available commands */
-static int _Console_Help(ConsoleRef console, ConsoleArgRef args)
+/* place a timer by the bits its frame shares with nextFrame */
+static void _ConsoleTimerWheel_Insert(struct ConsoleTimerWheel* wheel, int index)
 {
-    fprintf(Console_Log(console), "%i commands available\n", console->commandCount);
+    struct ConsoleTimer* timer = &wheel->timers[index];
     
-    int i;
-    for (i = 0; i < console->commandCount; i ++)
+    /* late timers run on the next frame */
+    if (timer->frame < wheel->nextFrame)
     {
-        fprintf(Console_Log(console), "%s ", console->commands[i]->name);
+        timer->frame = wheel->nextFrame;
     }
     
-    fprintf(Console_Log(console), "\n");
+    unsigned int delta = timer->frame ^ wheel->nextFrame;
     
-    return 1;
+    int level = 0;
+    while (level < CONSOLE_TIMER_LEVELS - 1 && (delta >> (CONSOLE_TIMER_SLOT_BITS * (level + 1))) != 0)
+    {
+        ++level;
+    }
+    
+    unsigned int slot = (timer->frame >> (CONSOLE_TIMER_SLOT_BITS * level)) & (CONSOLE_TIMER_SLOTS - 1);
+    _ConsoleTimerWheel_Link(wheel, index, level * CONSOLE_TIMER_SLOTS + (int)slot);
 }
 
-ConsoleRef Console_Create(FILE* logfile)
+/* return a timer to the free list, the caller owns its command */
+static void _ConsoleTimerWheel_Release(struct ConsoleTimerWheel* wheel, int index)
 {
-    if (!logfile)
+    struct ConsoleTimer* timer = &wheel->timers[index];
+    timer->command = NULL;
+    timer->list = -1;
+    timer->next = wheel->freeTimer;
+    wheel->freeTimer = index;
+    wheel->pendingCount--;
+}
+
+static void _ConsoleTimerWheel_Destroy(struct ConsoleTimerWheel* wheel)
+{
+    if (!wheel)
     {
-        return NULL;
+        return;
     }
     
-    ConsoleRef console = _Console_Malloc(sizeof(struct Console));
-    
-    if (console)
+    int i;
+    for (i = 0; i < wheel->timerCount; i ++)
     {
-        console->commandCount = 0;
-        console->varCount = 0;
-        console->logFile = logfile;
-        
-        /* only built-in command */
-        Console_RegisterCommand(console,
-                                "help",
-                                _Console_Help,
-                                0);
+        _Console_Free(wheel->timers[i].command);
     }
     
-    return console;
+    _Console_Free(wheel->timers);
+    _Console_Free(wheel);
 }
 
-void Console_Destroy(ConsoleRef console)
+static ConsoleTimerId_t _Console_Schedule(ConsoleRef console, const char* command, size_t length, unsigned int frame)
 {
-    if (console)
+    struct ConsoleTimerWheel* wheel = console->timers;
+    
+    if (!wheel)
     {
-        int i;
-        for (i = 0; i < console->commandCount; i ++)
+        wheel = _Console_Malloc(sizeof(struct ConsoleTimerWheel));
+        
+        if (!wheel)
         {
-            _Console_Free(console->commands[i]);
+            return 0;
         }
         
-        for (i = 0; i < console->varCount; i ++)
+        wheel->timers = NULL;
+        wheel->timerCount = 0;
+        wheel->timerCapacity = 0;
+        wheel->freeTimer = -1;
+        wheel->pendingCount = 0;
+        wheel->nextFrame = console->frame;
+        wheel->serial = 0;
+        wheel->ticking = 0;
+        
+        int i;
+        for (i = 0; i <= CONSOLE_TIMER_FIRING; i ++)
         {
-            _Console_Free(console->vars[i]);
+            wheel->heads[i] = -1;
         }
-        _Console_Free(console);
+        
+        console->timers = wheel;
     }
-}
-
-ConsoleVarRef Console_FindVar(ConsoleRef console, const char* name)
-{
-    assert(console);
-    assert(name);
     
-    int i;
-    for (i = 0; i < console->varCount; i ++)
+    char* copy = _Console_Malloc(length + 1);
+    
+    if (!copy)
     {
-        if (strcmp(console->vars[i]->name, name) == 0)
+        return 0;
+    }
+    
+    memcpy(copy, command, length);
+    copy[length] = '\0';
+    
+    int index = wheel->freeTimer;
+    
+    if (index >= 0)
+    {
+        wheel->freeTimer = wheel->timers[index].next;
+    }
+    else
+    {
+        struct ConsoleTimer* timers = _Console_ReserveArray(wheel->timers, sizeof(struct ConsoleTimer), wheel->timerCount, &wheel->timerCapacity, wheel->timerCount + 1);
+        
+        if (!timers)
         {
-            return console->vars[i];
+            _Console_Free(copy);
+            return 0;
         }
+        
+        wheel->timers = timers;
+        index = wheel->timerCount++;
     }
     
-    return NULL;
+    /* serial 0 is never used, so no id is 0 */
+    if (++wheel->serial == 0)
+    {
+        ++wheel->serial;
+    }
+    
+    struct ConsoleTimer* timer = &wheel->timers[index];
+    timer->command = copy;
+    timer->length = length;
+    timer->frame = frame;
+    timer->serial = wheel->serial;
+    timer->nested = console->executeDepth > 0;
+    
+    _ConsoleTimerWheel_Insert(wheel, index);
+    wheel->pendingCount++;
+    
+    return ((ConsoleTimerId_t)timer->serial << 32) | (ConsoleTimerId_t)index;
 }
 
-static ConsoleCommandRef _Console_FindCommand(ConsoleRef console, const char* name)
+ConsoleTimerId_t Console_ExecuteAt(ConsoleRef console, const char* command, unsigned int frame)
+{
+    assert(console);
+    assert(command);
+    
+    return _Console_Schedule(console, command, strlen(command), frame);
+}
+
+int Console_Cancel(ConsoleRef console, ConsoleTimerId_t timerId)
 {
-    for (int i = 0; i < console->commandCount; i ++)
+    assert(console);
+    
+    struct ConsoleTimerWheel* wheel = console->timers;
+    unsigned int index = (unsigned int)(timerId & 0xFFFFFFFFu);
+    
+    if (!wheel || index >= (unsigned int)wheel->timerCount)
     {
-        if (strcmp(console->commands[i]->name, name) == 0)
-        {
-            return console->commands[i];
-        }
+        return 0;
     }
     
-    return NULL;
+    struct ConsoleTimer* timer = &wheel->timers[index];
+    
+    if (timer->list < 0 || timer->serial != (unsigned int)(timerId >> 32))
+    {
+        return 0;
+    }
+    
+    _ConsoleTimerWheel_Unlink(wheel, (int)index);
+    _Console_Free(timer->command);
+    _ConsoleTimerWheel_Release(wheel, (int)index);
+    return 1;
 }
 
-void Console_Save(ConsoleRef console, FILE* outFile)
+/* cascade slots starting at frame, then run its level 0 slot - returns commands run */
+static int _ConsoleTimerWheel_Step(ConsoleRef console, struct ConsoleTimerWheel* wheel)
 {
-    assert(console);
-    assert(outFile);
+    unsigned int frame = wheel->nextFrame;
     
-    for (int i = 0; i < console->varCount; i ++)
+    /* higher levels first, their timers may land in lower slots due now */
+    int level;
+    for (level = CONSOLE_TIMER_LEVELS - 1; level > 0; level --)
     {
-        /* don't save readonly variables */
-        if (ConsoleVar_Readonly(console->vars[i]))
+        unsigned int shift = CONSOLE_TIMER_SLOT_BITS * (unsigned int)level;
+        
+        if ((frame & ((1u << shift) - 1)) != 0)
         {
             continue;
         }
         
-        fprintf(outFile, "%s : ", console->vars[i]->name);
+        int list = level * CONSOLE_TIMER_SLOTS + (int)((frame >> shift) & (CONSOLE_TIMER_SLOTS - 1));
+        int index = wheel->heads[list];
+        wheel->heads[list] = -1;
         
-        switch (console->vars[i]->type)
+        while (index >= 0)
         {
-            case kConsoleVarTypeString:
-                fprintf(outFile, "%s\n", console->vars[i]->stringValue);
-                break;
-            case kConsoleVarTypeInt:
-                fprintf(outFile, "%i\n", console->vars[i]->intValue);
-                break;
-            case kConsoleVarTypeDouble:
-                fprintf(outFile, "%lf\n", console->vars[i]->doubleValue);
-                break;
-            case kConsoleVarTypeBool:
-                fprintf(outFile, "%i\n", console->vars[i]->intValue);
-                break;
-            default:
-                break;
+            int next = wheel->timers[index].next;
+            _ConsoleTimerWheel_Insert(wheel, index);
+            index = next;
         }
     }
-}
-
-int Console_Load(ConsoleRef console, FILE* inFile)
-{
-    assert(console);
-    assert(inFile);
     
-    char varName[CONSOLE_VAR_NAME_MAX];
-    char varValue[CONSOLE_VAR_STRING_MAX];
+    int list = (int)(frame & (CONSOLE_TIMER_SLOTS - 1));
+    int index = wheel->heads[list];
+    wheel->heads[list] = -1;
     
-    while (!feof(inFile))
+    while (index >= 0)
     {
-        if (fscanf(inFile, "%s : ", varName) != 0)
-        {
-            ConsoleVarRef var = Console_FindVar(console, varName);
-            
-            if (!var)
-            {
-                return 0;
-            }
-            
-            switch (var->type)
-            {
-                case kConsoleVarTypeString:
-                {
-                    fscanf(inFile, "%s\n", varValue);
-                    ConsoleVar_SetStringValue(var, varValue);
-                    break;
-                }
-                case kConsoleVarTypeInt:
-                {
-                    int intVar;
-                    fscanf(inFile, "%i\n", &intVar);
-                    ConsoleVar_SetIntValue(var, intVar);
-                    break;
-                }
-                case kConsoleVarTypeBool:
-                {
-                    int intVar;
-                    fscanf(inFile, "%i\n", &intVar);
-                    ConsoleVar_SetIntValue(var, intVar);
-                    break;
-                }
-                case kConsoleVarTypeDouble:
-                {
-                    double doubleVar;
-                    fscanf(inFile, "%lf\n", &doubleVar);
-                    ConsoleVar_SetDoubleValue(var, doubleVar);
-                    break;
-                }
-                default:
-                    break;
-            }
-        }
-        else
-        {
-            return 0;
-        }
+        int next = wheel->timers[index].next;
+        _ConsoleTimerWheel_Link(wheel, index, CONSOLE_TIMER_FIRING);
+        index = next;
+    }
+    
+    /* commands scheduled from here on run next frame at the earliest */
+    wheel->nextFrame = frame + 1;
+    console->frame = frame;
+    
+    int ran = 0;
+    
+    /* commands may schedule and cancel, so nothing is held across them */
+    while (wheel->heads[CONSOLE_TIMER_FIRING] >= 0)
+    {
+        index = wheel->heads[CONSOLE_TIMER_FIRING];
+        struct ConsoleTimer* timer = &wheel->timers[index];
+        char* command = timer->command;
+        size_t length = timer->length;
+        int nested = timer->nested;
+        
+        _ConsoleTimerWheel_Unlink(wheel, index);
+        _ConsoleTimerWheel_Release(wheel, index);
+        
+        /* commands from other commands replay with their parents */
+        console->executeDepth += nested;
+        _Console_RunScript(console, "timer", command, length);
+        console->executeDepth -= nested;
+        
+        _Console_Free(command);
+        ++ran;
     }
-    return 1;
+    
+    return ran;
 }
 
-FILE* Console_Log(ConsoleRef console)
+int Console_Tick(ConsoleRef console, unsigned int frame)
 {
     assert(console);
-    return console->logFile;
+    assert(frame >= console->frame);
+    
+    struct ConsoleTimerWheel* wheel = console->timers;
+    int ran = 0;
+    
+    if (wheel)
+    {
+        assert(!wheel->ticking);
+        wheel->ticking = 1;
+        
+        while (wheel->pendingCount > 0 && wheel->nextFrame <= frame)
+        {
+            ran += _ConsoleTimerWheel_Step(console, wheel);
+        }
+        
+        /* with nothing pending there is nothing to cascade */
+        if (wheel->pendingCount == 0 && wheel->nextFrame <= frame)
+        {
+            wheel->nextFrame = frame + 1;
+        }
+        
+        wheel->ticking = 0;
+    }
+    
+    console->frame = frame;
+    return ran;
 }
 
-ConsoleCommandRef Console_RegisterCommand(ConsoleRef console,
-                                          const char* name,
-                                          ConsoleFunc_t consoleFunc,
-                                          int argCount)
+/* decode the record at offset, returns 0 at the end or on damage */
+static int _ConsoleReplay_Read(ConsoleReplayRef replay)
 {
-    assert(console);
-    assert(name);
+    replay->pending = 0;
     
-    ConsoleCommandRef newCommand = _ConsoleCommand_Create();
-    newCommand->func = consoleFunc;
-    newCommand->argCount = argCount;
-    strcpy(newCommand->name, name);
+    if (replay->offset >= replay->size)
+    {
+        return 0;
+    }
     
-    console->commands[console->commandCount] = newCommand;
-    console->commandCount++;
+    unsigned long long delta;
+    unsigned long long id;
     
-    return newCommand;
+    if (!_Console_GetVarint(replay->data, replay->size, &replay->offset, &delta) ||
+        !_Console_GetVarint(replay->data, replay->size, &replay->offset, &id) ||
+        id > (unsigned long long)replay->stringCount)
+    {
+        return 0;
+    }
+    
+    if (id == (unsigned long long)replay->stringCount)
+    {
+        unsigned long long length;
+        
+        if (!_Console_GetVarint(replay->data, replay->size, &replay->offset, &length) ||
+            length > replay->size - replay->offset)
+        {
+            return 0;
+        }
+        
+        struct ConsoleReplaySpan* strings = _Console_ReserveArray(replay->strings, sizeof(struct ConsoleReplaySpan), replay->stringCount, &replay->stringCapacity, replay->stringCount + 1);
+        
+        if (!strings)
+        {
+            return 0;
+        }
+        
+        replay->strings = strings;
+        replay->strings[replay->stringCount].text = (const char*)replay->data + replay->offset;
+        replay->strings[replay->stringCount].length = (size_t)length;
+        replay->stringCount++;
+        replay->offset += (size_t)length;
+    }
+    
+    replay->frame += (unsigned int)delta;
+    replay->id = (unsigned int)id;
+    replay->pending = 1;
+    return 1;
 }
 
-ConsoleVarRef Console_RegisterVar(ConsoleRef console,
-                                  const char* name,
-                                  ConsoleVarType_t type,
-                                  ConsoleVarFlag_t flags)
+ConsoleReplayRef ConsoleReplay_Open(ConsoleRef console, const char* path)
 {
     assert(console);
-    assert(name);
+    assert(path);
     
-    ConsoleVarRef newVar = _ConsoleVar_Create(type, 0);
-    strcpy(newVar->name, name);
+    size_t size = 0;
+    const void* data = _Console_MapFile(path, &size);
     
-    newVar->flags = flags;
+    if (!data)
+    {
+        return NULL;
+    }
     
-    console->vars[console->varCount] = newVar;
-    console->varCount++;
+    const unsigned char* bytes = data;
     
-    return newVar;
+    if (size < 8 || memcmp(bytes, "CREC", 4) != 0 || bytes[4] < 1 || bytes[4] > CONSOLE_RECORD_VERSION)
+    {
+        _Console_UnmapFile(data, size);
+        return NULL;
+    }
+    
+    ConsoleReplayRef replay = _Console_Malloc(sizeof(struct ConsoleReplay));
+    
+    if (!replay)
+    {
+        _Console_UnmapFile(data, size);
+        return NULL;
+    }
+    
+    replay->console = console;
+    replay->data = bytes;
+    replay->size = size;
+    replay->offset = 8;
+    replay->strings = NULL;
+    replay->stringCount = 0;
+    replay->stringCapacity = 0;
+    replay->frame = 0;
+    
+    _ConsoleReplay_Read(replay);
+    return replay;
 }
 
-static ConsoleArgRef _ArgCreate(ConsoleVarRef var)
+void ConsoleReplay_Close(ConsoleReplayRef replay)
 {
-    ConsoleArgRef arg = _Console_Malloc(sizeof(struct ConsoleArg));
-    arg->var = var;
-    arg->next = NULL;
-    return arg;
+    if (replay)
+    {
+        _Console_UnmapFile(replay->data, replay->size);
+        _Console_Free(replay->strings);
+        _Console_Free(replay);
+    }
 }
 
-static int _TokenIsFloat (const char *s)
+int ConsoleReplay_NextFrame(ConsoleReplayRef replay, unsigned int* outFrame)
 {
-    char* ep = NULL;
-    strtol(s, &ep, 10);
+    assert(replay);
+    assert(outFrame);
     
-    if (!*ep)
+    if (!replay->pending)
     {
         return 0;
     }
     
-    if (*ep == 'e'  ||
-        *ep == 'E'  ||
-        *ep == '.')
+    *outFrame = replay->frame;
+    return 1;
+}
+
+/* a CONSOLE_RECORD_SET_STRING record, terminated strings within the span */
+static void _ConsoleReplay_SetString(ConsoleRef console, const struct ConsoleReplaySpan* command)
+{
+    const char* name = command->text + 1;
+    const char* end = command->text + command->length;
+    const char* nameEnd = memchr(name, '\0', (size_t)(end - name));
+    
+    if (!nameEnd || end[-1] != '\0')
+    {
+        Console_Printf(console, "replay: damaged assignment\n");
+        return;
+    }
+    
+    ConsoleVarRef var = Console_FindVar(console, name);
+    
+    if (!var || var->type != kConsoleVarTypeString)
     {
-        return 1;
+        Console_Printf(console, "replay: no string var %s\n", name);
+        return;
     }
     
-    return 0;
+    ConsoleVar_SetStringValue(var, nameEnd + 1);
 }
 
-
-static int _Console_ParseTokens(ConsoleRef console,
-                                char* variableCommand,
-                                char** outTokens)
+int ConsoleReplay_RunFrame(ConsoleReplayRef replay, unsigned int frame)
 {
-    int tokenCounter = 0;
+    assert(replay);
     
-    int expectStatment = 1;
-    int parsingString = 0;
+    int executed = 0;
     
-    char* it = variableCommand;
-    
-    while (*it != '\0')
+    while (replay->pending && replay->frame <= frame)
     {
-        if (!parsingString)
+        const struct ConsoleReplaySpan* command = replay->strings + replay->id;
+        
+        if (command->length > 0 && command->text[0] == CONSOLE_RECORD_SET_STRING)
         {
-            /* treat new lines as termination */
-            if (*it == '\n')
-            {
-                *it = '\0';
-            }
+            _ConsoleReplay_SetString(replay->console, command);
         }
+        else
+        {
+            _Console_RunScript(replay->console, "replay", command->text, command->length);
+        }
+        
+        ++executed;
         
-        if (expectStatment)
+        _ConsoleReplay_Read(replay);
+    }
+    
+    return executed;
+}
+
+#ifndef CONSOLE_NO_THREADS
+int Console_Enqueue(ConsoleRef console, const char* command)
+{
+    assert(console);
+    assert(command);
+    
+    size_t length = strlen(command) + 1;
+    
+    if (length > CONSOLE_QUEUE_COMMAND_MAX)
+    {
+        return -1;
+    }
+    
+    struct ConsoleQueue* queue = &console->queue;
+    struct ConsoleQueueSlot* slot;
+    size_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    
+    for (;;)
+    {
+        slot = &queue->slots[position & (CONSOLE_QUEUE_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        long long difference = (long long)sequence - (long long)position;
+        
+        if (difference == 0)
         {
-            /* start string */
-            if (*it == '\"')
+            /* slot is free, try to claim it */
+            if (atomic_compare_exchange_weak_explicit(&queue->tail,
+                                                      &position,
+                                                      position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
             {
-                parsingString = 1;
+                break;
             }
-            
-            /* new token */
-            outTokens[tokenCounter] = it;
-            tokenCounter++;
-            expectStatment = 0;
         }
-        else if (parsingString)
+        else if (difference < 0)
         {
-            /* begin string */
-            if (*it == '\"')
-            {
-                *it = '\0';
-                parsingString = 0;
-            }
+            /* console thread hasn't consumed this slot yet */
+            return 0;
         }
         else
         {
-            /* convert white space to termination */
-            if (isspace(*it))
-            {
-                *it = '\0';
-                expectStatment = 1;
-            }
+            /* another producer claimed it */
+            position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
         }
-        
-        it ++;
     }
     
-    if (parsingString)
-    {
-        fprintf(Console_Log(console), "trailing quote\n");
-    }
+    memcpy(slot->command, command, length);
     
-    return tokenCounter;
+    /* publish to the console thread */
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    return 1;
 }
 
-static void _Console_FreeArgChain(ConsoleArgRef arg)
+int Console_DrainQueue(ConsoleRef console, int maxCommands, int maxMicroseconds)
 {
-    ConsoleArgRef it = arg;
+    assert(console);
+    
+    struct ConsoleQueue* queue = &console->queue;
+    long long deadline = 0;
+    
+    if (maxMicroseconds > 0)
+    {
+        deadline = _Console_Now() + (long long)maxMicroseconds * 1000LL;
+    }
     
-    while (it)
+    int executed = 0;
+    
+    while (maxCommands <= 0 || executed < maxCommands)
     {
-        ConsoleArgRef next = it->next;
+        struct ConsoleQueueSlot* slot = &queue->slots[queue->head & (CONSOLE_QUEUE_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
         
-        if (it->var->temp)
+        if (sequence != queue->head + 1)
         {
-            _Console_Free(it->var);
+            /* empty, or a producer is still copying */
+            break;
         }
-        _Console_Free(it);
         
-        it = next;
+        Console_Execute(console, slot->command);
+        executed++;
+        
+        /* hand the slot back to producers for the next lap */
+        atomic_store_explicit(&slot->sequence, queue->head + CONSOLE_QUEUE_CAPACITY, memory_order_release);
+        queue->head++;
+        
+        if (deadline && _Console_Now() >= deadline)
+        {
+            break;
+        }
     }
+    
+    return executed;
 }
 
-int Console_Execute(ConsoleRef console, const char* staticCommandString)
+static size_t _Console_RoundPow2(size_t n)
 {
-    assert(console);
-    assert(staticCommandString);
+    size_t size = 1;
+    
+    while (size < n)
+    {
+        size <<= 1;
+    }
     
-    char commandString[CONSOLE_VAR_NAME_MAX];
-    strcpy(commandString, staticCommandString);
+    return size;
+}
+
+ConsoleLogRingRef ConsoleLogRing_Create(size_t byteBudget)
+{
+    struct ConsoleLogRing* ring = _Console_Malloc(sizeof(struct ConsoleLogRing));
     
+    if (!ring)
+    {
+        return NULL;
+    }
     
-    char* tokens[CONSOLE_MAX_TOKENS];
-    int tokenCount = _Console_ParseTokens(console, commandString, tokens);
+    ring->capacity = _Console_RoundPow2(byteBudget < 256 ? 256 : byteBudget);
+    ring->lineCapacity = ring->capacity / CONSOLE_LOG_RING_LINE_BYTES;
+    ring->data = _Console_Malloc(ring->capacity);
+    ring->lines = _Console_Malloc(sizeof(struct ConsoleLogRingLine) * ring->lineCapacity);
     
-    if (tokenCount < 1)
+    if (!ring->data || !ring->lines)
     {
-        fprintf(Console_Log(console), "nothing to execute\n");
-        return 0;
+        _Console_Free(ring->data);
+        _Console_Free(ring->lines);
+        _Console_Free(ring);
+        return NULL;
     }
     
-    ConsoleArgRef argChain = NULL;
-    int argCount = 0;
+    atomic_init(&ring->first, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->pin, ULLONG_MAX);
+    atomic_init(&ring->dropped, 0);
     
-    ConsoleCommandRef command = _Console_FindCommand(console, tokens[0]);
+    ring->openStart = 0;
+    ring->openLength = 0;
+    ring->dropping = 0;
+    return ring;
+}
+
+void ConsoleLogRing_Destroy(ConsoleLogRingRef ring)
+{
+    if (!ring)
+    {
+        return;
+    }
     
-    if (!command)
+    _Console_Free(ring->data);
+    _Console_Free(ring->lines);
+    _Console_Free(ring);
+}
+
+/*
+ discard the oldest line. the writer moves first past the line
+ before checking pin and the reader pins before checking first,
+ so at least one of them sees the other - returns success
+ */
+static int _ConsoleLogRing_Evict(struct ConsoleLogRing* ring, unsigned long long first)
+{
+    atomic_store(&ring->first, first + 1);
+    
+    if (atomic_load(&ring->pin) <= first)
     {
-        printf("unknown command: %s\n", tokens[0]);
+        atomic_store(&ring->first, first);
         return 0;
     }
     
+    return 1;
+}
+
+/* make room for the open line to end at end - returns success */
+static int _ConsoleLogRing_Reserve(struct ConsoleLogRing* ring, unsigned long long end)
+{
+    unsigned long long first = atomic_load_explicit(&ring->first, memory_order_relaxed);
+    unsigned long long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
     
-    int i;
-    for (i = 1; i < tokenCount; i++)
+    while (first < tail && ring->lines[first & (ring->lineCapacity - 1)].start + ring->capacity < end)
     {
-        const char* argToken = tokens[i];
-        
-        ConsoleArgRef newArg = NULL;
-        
-        /* string */
-        if (*argToken == '\"' || *argToken == '-')
+        if (!_ConsoleLogRing_Evict(ring, first))
         {
-            newArg = _ArgCreate(_ConsoleVar_Create(kConsoleVarTypeString, 1));            
-            strcpy(newArg->var->stringValue, argToken + 1);
-            newArg->var->flags = kConsoleVarFlagReadonly;
+            return 0;
         }
-        else
-        {
-            ConsoleVarRef var = Console_FindVar(console, argToken);
-            
-            /* variable */
-            if (var)
-            {
-                newArg = _ArgCreate(var);
-            }
-            else
-            {
-                int found = 0;
+        
+        ++first;
+    }
+    
+    return 1;
+}
 
-                if (_TokenIsFloat(argToken))
-                {
-                    /* double */
-                    double doubleValue;
-                    if (sscanf(argToken, "%lf", &doubleValue) != 0)
-                    {
-                        newArg = _ArgCreate(_ConsoleVar_Create(kConsoleVarTypeDouble, 1));
-                        newArg->var->doubleValue = doubleValue;
-                        newArg->var->flags = kConsoleVarFlagReadonly;
-                        found = 1;
-                    }
-                }
-                else
-                {
-                    /* int */
-                    int intValue;
-                    if (sscanf(argToken, "%d", &intValue) != 0)
-                    {
-                        newArg = _ArgCreate(_ConsoleVar_Create(kConsoleVarTypeInt, 1));
-                        newArg->var->intValue = intValue;
-                        newArg->var->flags = kConsoleVarFlagReadonly;
-                        found = 1;
-                    }
-                }
-                
-                if (!found)
-                {
-                    fprintf(Console_Log(console), "unknown symbol: \"%s\"\n", argToken);
-                    _Console_FreeArgChain(argChain);
-                    return 0;
-                }
-            }
-        }
+static void _ConsoleLogRing_Drop(struct ConsoleLogRing* ring)
+{
+    ring->dropping = 1;
+    ring->openLength = 0;
+}
+
+/* add text without newlines to the open line */
+static void _ConsoleLogRing_Append(struct ConsoleLogRing* ring, const char* text, size_t length)
+{
+    if (ring->dropping)
+    {
+        return;
+    }
+    
+    /* longer lines are cut */
+    if (length > ring->capacity - ring->openLength)
+    {
+        length = ring->capacity - ring->openLength;
+    }
+    
+    if (length == 0)
+    {
+        return;
+    }
+    
+    size_t offset = (size_t)(ring->openStart & (ring->capacity - 1));
+    
+    if (offset + ring->openLength + length > ring->capacity)
+    {
+        /* crossing the end, restart the line at the front */
+        unsigned long long start = ring->openStart - offset + ring->capacity;
         
-        if (newArg)
+        if (!_ConsoleLogRing_Reserve(ring, start + ring->openLength + length))
         {
-            if (argChain)
-            {
-                argChain->next = newArg;
-            }
-            else
-            {
-                argChain = newArg;
-            }
-            argCount++;
+            _ConsoleLogRing_Drop(ring);
+            return;
         }
+        
+        memmove(ring->data, ring->data + offset, ring->openLength);
+        ring->openStart = start;
+        offset = 0;
+    }
+    else if (!_ConsoleLogRing_Reserve(ring, ring->openStart + ring->openLength + length))
+    {
+        _ConsoleLogRing_Drop(ring);
+        return;
     }
     
-    int fail = 0;
-    if (command->argCount >= 0)
+    memcpy(ring->data + offset + ring->openLength, text, length);
+    ring->openLength += length;
+}
+
+static void _ConsoleLogRing_Publish(struct ConsoleLogRing* ring)
+{
+    unsigned long long first = atomic_load_explicit(&ring->first, memory_order_relaxed);
+    unsigned long long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    
+    if (!ring->dropping && tail - first == ring->lineCapacity && !_ConsoleLogRing_Evict(ring, first))
     {
-        if (command->argCount != argCount)
-        {
-            fprintf(Console_Log(console), "%s: expected %i arguments\n", command->name, command->argCount);
-            fail = 1;
-        }
+        _ConsoleLogRing_Drop(ring);
     }
     
-    if (!fail)
+    if (ring->dropping)
     {
-        fail = !command->func(console, argChain);
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        ring->dropping = 0;
+        return;
     }
     
-    if (fail)
+    struct ConsoleLogRingLine* line = ring->lines + (tail & (ring->lineCapacity - 1));
+    line->start = ring->openStart;
+    line->length = ring->openLength;
+    
+    ring->openStart += ring->openLength;
+    ring->openLength = 0;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+void ConsoleLogRing_Write(const char* text, size_t length, void* context)
+{
+    struct ConsoleLogRing* ring = context;
+    assert(ring);
+    
+    const char* end = text + length;
+    
+    while (text < end)
     {
-        fprintf(Console_Log(console), "%s failed\n", command->name);
+        const char* newline = memchr(text, '\n', (size_t)(end - text));
+        
+        if (!newline)
+        {
+            _ConsoleLogRing_Append(ring, text, (size_t)(end - text));
+            break;
+        }
+        
+        _ConsoleLogRing_Append(ring, text, (size_t)(newline - text));
+        _ConsoleLogRing_Publish(ring);
+        text = newline + 1;
     }
+}
+
+unsigned long long ConsoleLogRing_LineCount(ConsoleLogRingRef ring)
+{
+    assert(ring);
+    return atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+unsigned long long ConsoleLogRing_BeginRead(ConsoleLogRingRef ring, unsigned long long from)
+{
+    assert(ring);
     
-    _Console_FreeArgChain(argChain);
+    while (1)
+    {
+        atomic_store(&ring->pin, from);
+        unsigned long long first = atomic_load(&ring->first);
+        
+        if (first <= from)
+        {
+            return from;
+        }
+        
+        from = first;
+    }
+}
+
+const char* ConsoleLogRing_Line(ConsoleLogRingRef ring, unsigned long long line, size_t* length)
+{
+    assert(ring);
+    assert(length);
+    assert(line >= atomic_load_explicit(&ring->pin, memory_order_relaxed));
+    assert(line < atomic_load_explicit(&ring->tail, memory_order_acquire));
     
-    return 1;
+    const struct ConsoleLogRingLine* record = ring->lines + (line & (ring->lineCapacity - 1));
+    *length = record->length;
+    return ring->data + (record->start & (ring->capacity - 1));
+}
+
+void ConsoleLogRing_EndRead(ConsoleLogRingRef ring)
+{
+    assert(ring);
+    atomic_store(&ring->pin, ULLONG_MAX);
+}
+
+unsigned long long ConsoleLogRing_Dropped(ConsoleLogRingRef ring)
+{
+    assert(ring);
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
 }
+#endif
@@ -10,14 +10,33 @@
 
 #include <stdio.h>
 
+/*
+ thread safe features need C11 atomics.
+ define CONSOLE_NO_THREADS to compile them out.
+ */
+#if !defined(CONSOLE_NO_THREADS) && (!defined(__STDC_VERSION__) || __STDC_VERSION__ < 201112L || defined(__STDC_NO_ATOMICS__))
+#define CONSOLE_NO_THREADS
+#endif
+
+/* background saving also needs POSIX threads and files */
+#if !defined(CONSOLE_NO_ASYNC_SAVE) && (defined(CONSOLE_NO_THREADS) || defined(_WIN32))
+#define CONSOLE_NO_ASYNC_SAVE
+#endif
+
+/*
+ define CONSOLE_PROFILE to time every command, see Console_GetStats.
+ without it there is no timing code or storage
+ */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
     
 #define CONSOLE_VERSION_1_0 0
 #define CONSOLE_VERSION_1_1 1
+#define CONSOLE_VERSION_1_2 2
 
-#define CONSOLE_VERSION CONSOLE_VERSION_1_1
+#define CONSOLE_VERSION CONSOLE_VERSION_1_2
 
 /*
  v1.0:
@@ -26,8 +45,47 @@ extern "C" {
  v1.1:
  - Custom Memory alloactor support
  
+ v1.2:
+ - Hashed var and command lookup
+ - Unlimited vars and commands, Console_Reserve
+ - Compact vars with interned names, Console_MemoryStats
+ - Argument literals are allocated from a per console arena
+ - Precompiled commands, Console_Compile and Console_Run
+ - Registering an existing name shadows the earlier symbol
+ - Vars bound to game memory, Console_BindVar
+ - Lock-free command queue for other threads, Console_Enqueue
+ - Wait-free reads from other threads, kConsoleVarFlagConcurrent
+ - Change callbacks and generations, ConsoleVarSet
+ - Commands taking argument arrays, Console_RegisterCommandArgv
+ - Typed command signatures, Console_RegisterCommandTyped
+ - Binary snapshots, Console_SaveSnapshot and Console_LoadSnapshot
+ - Var defaults, Console_SaveModified and an append-only journal
+ - Background saving, Console_SaveAsync
+ - Scripts, Console_ExecuteScript and Console_ExecuteFile
+ - Round trip number formatting, Console_FormatDouble
+ - Pluggable output, Console_SetOutput, and a lock-free log ring
+ - Sorted name index, Console_Complete and Console_List
+ - Per command profiling with CONSOLE_PROFILE, Console_GetStats
+ - Chrome trace export, Console_StartTrace and Console_WriteTrace
+ - Command recording and replay by frame, Console_StartRecording
+ - Copy on write var snapshots, Console_Snapshot and Console_Restore
+ - Scheduled commands, Console_ExecuteAt, Console_Tick and wait
+ - Key bindings, Console_BindKey and Console_KeyEvent
+ 
  */
 
+/* buffer size for Console_FormatInt and Console_FormatDouble */
+#define CONSOLE_NUMBER_STRING_MAX 32
+
+/* size of Console_Enqueue commands, including terminator */
+#define CONSOLE_QUEUE_COMMAND_MAX 256
+
+/* key codes for bindings are below this */
+#define CONSOLE_KEY_MAX 4096
+
+/* size of kConsoleVarFlagConcurrent string values, including terminator */
+#define CONSOLE_VAR_CONCURRENT_STRING_MAX 256
+
 typedef enum
 {
     kConsoleVarTypeDouble = 0,
@@ -41,14 +99,38 @@ typedef enum
 {
     /* can commands modify this? */
     kConsoleVarFlagReadonly = 1 << 0,
+    
+    /*
+     value may be read from other threads while the console thread
+     writes it. reads never lock or see torn values.
+     strings are limited to CONSOLE_VAR_CONCURRENT_STRING_MAX bytes and
+     must be read with ConsoleVar_CopyStringValue off the console thread.
+     requires threads, can't be combined with Console_BindVar.
+     */
+    kConsoleVarFlagConcurrent = 1 << 1,
 
 } ConsoleVarFlag_t;
 
+/* what a name is registered as, a name may be both */
+typedef enum
+{
+    kConsoleSymbolVar = 1 << 0,
+    kConsoleSymbolCommand = 1 << 1,
+    
+} ConsoleSymbol_t;
+
 
 typedef struct ConsoleVar* ConsoleVarRef;
 typedef struct ConsoleArg* ConsoleArgRef;
 typedef struct ConsoleCommand* ConsoleCommandRef;
 typedef struct Console* ConsoleRef;
+typedef struct ConsoleCompiled* ConsoleCompiledRef;
+typedef struct ConsoleVarSet* ConsoleVarSetRef;
+typedef struct ConsoleReplay* ConsoleReplayRef;
+typedef struct ConsoleVarSnapshot* ConsoleVarSnapshotRef;
+
+/* a scheduled command, 0 when scheduling failed */
+typedef unsigned long long ConsoleTimerId_t;
 
 struct ConsoleArg
 {
@@ -59,6 +141,82 @@ struct ConsoleArg
 
 typedef int (*ConsoleFunc_t)(ConsoleRef console, ConsoleArgRef arguments);
 
+/* an argument as seen by ConsoleArgvFunc_t commands */
+typedef struct
+{
+    ConsoleVarType_t type;
+    /* the var named by the argument, NULL for literals */
+    ConsoleVarRef var;
+    /* read by type, strings are valid during the call */
+    union
+    {
+        int intValue;
+        double doubleValue;
+        const char* stringValue;
+    } value;
+} ConsoleArgView_t;
+
+typedef int (*ConsoleArgvFunc_t)(ConsoleRef console, int argc, const ConsoleArgView_t* argv);
+
+/* called on the console thread after a var's value changes */
+typedef void (*ConsoleVarCallback_t)(ConsoleVarRef var, void* context);
+
+#ifdef CONSOLE_PROFILE
+/* bucket i counts durations of 2^i to 2^(i+1) - 1 nanoseconds */
+#define CONSOLE_HISTOGRAM_BUCKETS 32
+
+typedef struct
+{
+    unsigned long long count;
+    unsigned long long totalNanoseconds;
+    unsigned long long maxNanoseconds;
+    unsigned int buckets[CONSOLE_HISTOGRAM_BUCKETS];
+} ConsoleHistogram_t;
+
+typedef struct
+{
+    const char* name;
+    /* executions, including ones with bad arguments */
+    unsigned long long calls;
+    unsigned long long failures;
+    
+    /* splitting the statement into tokens, not recorded for Console_Run */
+    ConsoleHistogram_t parse;
+    /* finding the command and its arguments */
+    ConsoleHistogram_t lookup;
+    /* the command function */
+    ConsoleHistogram_t handler;
+} ConsoleCommandStats_t;
+#endif
+
+/* receives names in sorted order, symbols are ConsoleSymbol_t bits */
+typedef void (*ConsoleNameCallback_t)(const char* name, unsigned int symbols, void* context);
+
+/* receives console output, text is not null terminated */
+typedef void (*ConsoleOutputFunc_t)(const char* text, size_t length, void* context);
+
+/* called on the console thread by Console_PollSaves */
+typedef void (*ConsoleSaveCallback_t)(ConsoleRef console, const char* path, int success, void* context);
+
+/* bytes held by a console, see Console_MemoryStats */
+typedef struct
+{
+    size_t varCount;
+    size_t commandCount;
+    
+    /* var and command records */
+    size_t varBytes;
+    size_t commandBytes;
+    /* interned names */
+    size_t nameBytes;
+    /* string values too long to store inside their var */
+    size_t stringBytes;
+    /* registries and hash indices */
+    size_t indexBytes;
+    
+    size_t totalBytes;
+} ConsoleMemoryStats_t;
+
 /* for custom allocators */
 extern void Console_InstallAllocators(void *(*mallocFunc)(size_t sz), void (*freeFunc)(void *ptr));
 
@@ -66,6 +224,7 @@ extern void Console_InstallAllocators(void *(*mallocFunc)(size_t sz), void (*fre
 /* ConsoleVar */
 extern ConsoleVarType_t ConsoleVar_Type(ConsoleVarRef var);
 extern int ConsoleVar_Readonly(ConsoleVarRef var);
+extern const char* ConsoleVar_Name(ConsoleVarRef var);
 
 extern void ConsoleVar_SetDoubleValue(ConsoleVarRef var, double value);
 extern double ConsoleVar_DoubleValue(ConsoleVarRef var);
@@ -83,36 +242,379 @@ extern int ConsoleVar_BoolValue(ConsoleVarRef var);
 extern void ConsoleVar_SetStringValue(ConsoleVarRef var, const char* string);
 extern const char* ConsoleVar_StringValue(ConsoleVarRef var);
 
+/* ConsoleArgView_t, with the same conversions as ConsoleVar */
+extern double ConsoleArgView_DoubleValue(const ConsoleArgView_t* view);
+extern int ConsoleArgView_IntValue(const ConsoleArgView_t* view);
+extern const char* ConsoleArgView_StringValue(const ConsoleArgView_t* view);
+
+/*
+ copy a string value into buffer, truncating to bufferSize.
+ safe on any thread for kConsoleVarFlagConcurrent vars
+ */
+extern void ConsoleVar_CopyStringValue(ConsoleVarRef var, char* buffer, size_t bufferSize);
+
+/*
+ number formatting used for echo and saving, without stdio.
+ buffer holds CONSOLE_NUMBER_STRING_MAX bytes - returns length.
+ doubles get the shortest digits that read back to the same value
+ (rarely a digit more), with ".0" on whole numbers
+ */
+extern int Console_FormatInt(int value, char* buffer);
+extern int Console_FormatDouble(double value, char* buffer);
+
 /* Console */
 extern ConsoleRef Console_Create(FILE* logfile);
 extern void Console_Destroy(ConsoleRef console);
 
+/*
+ registries grow as needed, reserving up front avoids
+ reallocating while registering - returns success
+ */
+extern int Console_Reserve(ConsoleRef console, int varCount, int commandCount);
+
+extern void Console_MemoryStats(ConsoleRef console, ConsoleMemoryStats_t* outStats);
+
 /* save current settings to file */
 extern void Console_Save(ConsoleRef console, FILE* outFile);
 /* load settings from file - returns success */
 extern int Console_Load(ConsoleRef console, FILE* inFile);
+
+#ifndef CONSOLE_NO_ASYNC_SAVE
+/*
+ Console_Save to path without blocking. values are copied now and
+ written on a worker thread to a temp file that replaces path once it
+ is on disk, so a crash never leaves a partial file. saves run in order.
+ callback may be NULL - returns 0 if out of memory
+ */
+extern int Console_SaveAsync(ConsoleRef console,
+                             const char* path,
+                             ConsoleSaveCallback_t callback,
+                             void* context);
+
+/*
+ call from the console thread, e.g. once per frame, to deliver callbacks
+ of finished saves - returns how many finished.
+ Console_Destroy waits for pending saves without calling back
+ */
+extern int Console_PollSaves(ConsoleRef console);
+#endif
+
+/*
+ vars remember a default value, zero or the bound value when registered.
+ mark the current values as defaults once startup has set them
+ */
+extern void ConsoleVar_MarkDefault(ConsoleVarRef var);
+extern void Console_MarkDefaults(ConsoleRef console);
+/* does the value differ from the default? */
+extern int ConsoleVar_Modified(ConsoleVarRef var);
+extern void ConsoleVar_ResetToDefault(ConsoleVarRef var);
+
+/*
+ copy on write snapshots of var values. taking one copies only bound
+ vars, the first change of any other var afterwards saves its old value,
+ and restoring sets back only the vars changed since. restoring drops
+ newer snapshots, the restored one stays usable until released
+ */
+extern ConsoleVarSnapshotRef Console_Snapshot(ConsoleRef console);
+extern void Console_Restore(ConsoleRef console, ConsoleVarSnapshotRef snapshot);
+extern void Console_ReleaseSnapshot(ConsoleVarSnapshotRef snapshot);
+
+/* Console_Save limited to modified vars */
+extern void Console_SaveModified(ConsoleRef console, FILE* outFile);
+
+/*
+ journal files are Console_Save lines appended over time, later lines win.
+ Console_Load replays them.
+ appends vars changed since the last append or compaction,
+ cost follows the number of changes - returns vars written, -1 on error
+ */
+extern int Console_AppendJournal(ConsoleRef console, FILE* journalFile);
+/* write the modified vars to an emptied journal file - returns success */
+extern int Console_CompactJournal(ConsoleRef console, FILE* journalFile);
+/* entries appended since the last compaction, to decide when to compact */
+extern int Console_JournalLength(ConsoleRef console);
+
+/*
+ binary version of Console_Save for fast loading, not portable
+ between machines of different byte order - returns success
+ */
+extern int Console_SaveSnapshot(ConsoleRef console, FILE* outFile);
+/*
+ map a snapshot file and apply it. vars no longer registered are skipped,
+ a damaged file changes nothing - returns success
+ */
+extern int Console_LoadSnapshot(ConsoleRef console, const char* path);
+/* Console_LoadSnapshot from memory */
+extern int Console_ApplySnapshot(ConsoleRef console, const void* data, size_t size);
 /* the file commands should log to (fprintf) */
 
 extern ConsoleVarRef Console_FindVar(ConsoleRef console, const char* name);
 
+/*
+ visit every var and command name starting with prefix, for tab
+ completion. cost depends on the prefix and matches, not the number
+ of names - returns the number of matches
+ */
+extern int Console_Complete(ConsoleRef console, const char* prefix, ConsoleNameCallback_t callback, void* context);
+/* Console_Complete for a pattern where '*' matches any characters and '?' one */
+extern int Console_List(ConsoleRef console, const char* pattern, ConsoleNameCallback_t callback, void* context);
+
+/* the log file itself, writing to it bypasses Console_SetOutput */
 extern FILE* Console_Log(ConsoleRef console);
 
-/* register a new command */
+/*
+ send console output somewhere other than the log file.
+ a NULL outputFunc restores the log file
+ */
+extern void Console_SetOutput(ConsoleRef console, ConsoleOutputFunc_t outputFunc, void* context);
+/* write to the console output, commands should use these */
+extern void Console_Write(ConsoleRef console, const char* text, size_t length);
+extern void Console_Printf(ConsoleRef console, const char* format, ...);
+
+/* register a new command - returns NULL if out of memory */
 extern ConsoleCommandRef Console_RegisterCommand(ConsoleRef console,
                                                  const char* name,
                                                  ConsoleFunc_t consoleFunc,
                                                  /* if argCount -1 any number of arguments are valid */
                                                  int argCount);
 
-/* register a new variable */
+/*
+ register a command receiving its arguments as an array.
+ literals are passed by value without creating vars
+ */
+extern ConsoleCommandRef Console_RegisterCommandArgv(ConsoleRef console,
+                                                     const char* name,
+                                                     ConsoleArgvFunc_t argvFunc,
+                                                     /* if argCount -1 any number of arguments are valid */
+                                                     int argCount);
+
+/*
+ register a command with declared argument types, one character each:
+ 'i' int, 'f' double, 'b' bool, 's' string. "ifs" takes an int, a double
+ and a string. arguments are checked and converted before dispatch,
+ so argv[i].type always matches the signature. ints and bools convert
+ to other number types, doubles only as whole number literals, strings
+ only match 's'
+ - returns NULL if the signature has another character
+ */
+extern ConsoleCommandRef Console_RegisterCommandTyped(ConsoleRef console,
+                                                      const char* name,
+                                                      ConsoleArgvFunc_t argvFunc,
+                                                      const char* signature);
+
+/* register a new variable - returns NULL if out of memory */
 extern ConsoleVarRef Console_RegisterVar(ConsoleRef console,
                                          const char* name,
                                          ConsoleVarType_t type,
                                          ConsoleVarFlag_t flags);
 
-/* exectue a command string, returns success */
+/*
+ listen for changes made through the setters, including commands.
+ setting a var to its current value is not a change.
+ one callback per var, NULL removes it
+ */
+extern void ConsoleVar_SetChangeCallback(ConsoleVarRef var,
+                                         ConsoleVarCallback_t callback,
+                                         void* context);
+
+/*
+ every change bumps the console generation. remember it once per frame
+ and ask what changed since then
+ */
+extern unsigned long long Console_Generation(ConsoleRef console);
+extern int ConsoleVar_ChangedSince(ConsoleVarRef var, unsigned long long generation);
+
+/* fills outVars with vars changed after generation - returns count */
+extern int Console_ChangedVars(ConsoleRef console,
+                               unsigned long long generation,
+                               ConsoleVarRef* outVars,
+                               int maxVars);
+
+/* the vars one subsystem cares about, queried a word of vars at a time */
+extern ConsoleVarSetRef ConsoleVarSet_Create(ConsoleRef console);
+extern void ConsoleVarSet_Destroy(ConsoleVarSetRef set);
+/* returns success */
+extern int ConsoleVarSet_Add(ConsoleVarSetRef set, ConsoleVarRef var);
+/* Console_ChangedVars limited to the set */
+extern int ConsoleVarSet_Changed(ConsoleVarSetRef set,
+                                 unsigned long long generation,
+                                 ConsoleVarRef* outVars,
+                                 int maxVars);
+
+/*
+ register a variable stored in game memory instead of the console.
+ storage must outlive the console and point to a double for
+ kConsoleVarTypeDouble or an int for kConsoleVarTypeInt and Bool.
+ the game may read and write it directly, but the console can't see
+ those writes: call ConsoleVar_NotifyChanged after one for change
+ callbacks, generations, the journal and change queries to follow.
+ */
+extern ConsoleVarRef Console_BindVar(ConsoleRef console,
+                                     const char* name,
+                                     ConsoleVarType_t type,
+                                     void* storage,
+                                     ConsoleVarFlag_t flags);
+
+/* string version of Console_BindVar, longer values are truncated to fit */
+extern ConsoleVarRef Console_BindStringVar(ConsoleRef console,
+                                           const char* name,
+                                           char* buffer,
+                                           size_t bufferSize,
+                                           ConsoleVarFlag_t flags);
+
+/* report a direct write to a bound var's memory, as setting it would */
+extern void ConsoleVar_NotifyChanged(ConsoleVarRef var);
+
+/*
+ exectue a single statement, for more use Console_ExecuteScript.
+ returns 0 if it couldn't run, failing commands still return 1
+ */
 extern int Console_Execute(ConsoleRef console, const char* command);
 
+/*
+ execute every statement in text, which need not be terminated.
+ statements are separated by new lines or ';', '#' and '//' start
+ comments. errors are logged with line numbers and execution continues
+ - returns 1 if every statement succeeded
+ */
+extern int Console_ExecuteScript(ConsoleRef console, const char* script, size_t length);
+/* Console_ExecuteScript on a file, which is mapped rather than copied */
+extern int Console_ExecuteFile(ConsoleRef console, const char* path);
+
+/*
+ resolve a single statement once for repeated execution.
+ handles are owned by the console and stay valid until released
+ or the console is destroyed - returns NULL on error, or if more
+ than one statement is given
+ */
+extern ConsoleCompiledRef Console_Compile(ConsoleRef console, const char* command);
+/* execute a compiled command without parsing, returns success */
+extern int Console_Run(ConsoleCompiledRef compiled);
+extern void Console_ReleaseCompiled(ConsoleCompiledRef compiled);
+
+/*
+ bind a single statement to a key code, replacing any earlier binding.
+ the command is compiled now, so key events don't parse.
+ a command named +name runs -name on release if it exists.
+ Console_Save writes bindings and Console_Load restores them
+ - returns success
+ */
+extern int Console_BindKey(ConsoleRef console, int key, const char* command);
+extern void Console_UnbindKey(ConsoleRef console, int key);
+/* the bound command, NULL if none */
+extern const char* Console_KeyBinding(ConsoleRef console, int key);
+/* run the key's command for a press or release - returns 1 if one ran */
+extern int Console_KeyEvent(ConsoleRef console, int key, int down);
+
+/*
+ record commands, scripts, saves and loads as trace events from any
+ thread. each thread gets a buffer of eventsPerThread events, allocated
+ the first time it records. full buffers drop new events.
+ events are kept until the console is destroyed - returns success
+ */
+extern int Console_StartTrace(ConsoleRef console, int eventsPerThread);
+/* stop recording, events already recorded are kept */
+extern void Console_StopTrace(ConsoleRef console);
+/* write events as Chrome trace JSON for chrome://tracing or Perfetto - returns success */
+extern int Console_WriteTrace(ConsoleRef console, FILE* outFile);
+/* events lost to full buffers */
+extern int Console_TraceDropped(ConsoleRef console);
+
+/*
+ the game's frame number, stamped on recorded commands.
+ frames must never decrease
+ */
+extern void Console_SetFrame(ConsoleRef console, unsigned int frame);
+extern unsigned int Console_Frame(ConsoleRef console);
+
+/*
+ run command, which may be a script, once Console_Tick reaches frame.
+ frames already run go on the next tick. scripts can also use
+ "wait 30" to run the rest of the script 30 frames later.
+ scheduling and cancelling are O(1)
+ */
+extern ConsoleTimerId_t Console_ExecuteAt(ConsoleRef console, const char* command, unsigned int frame);
+/* returns 0 if the command already ran or was cancelled */
+extern int Console_Cancel(ConsoleRef console, ConsoleTimerId_t timerId);
+/*
+ set the frame and run commands scheduled up to it, in frame order.
+ call every frame, skipped frames are stepped through. commands
+ scheduled for the current frame while ticking run next frame
+ - returns commands run
+ */
+extern int Console_Tick(ConsoleRef console, unsigned int frame);
+
+/*
+ write every command reaching the console to outFile in a compact
+ binary form: statements from Console_Execute and scripts, compiled
+ commands run, and loaded vars as set commands. commands run by
+ other commands aren't recorded, they run again on replay.
+ writes are buffered - returns success
+ */
+extern int Console_StartRecording(ConsoleRef console, FILE* outFile);
+/* flush the recording, outFile stays open - returns 0 if a write failed */
+extern int Console_StopRecording(ConsoleRef console);
+
+/* open a recording to run its commands again - returns NULL if it isn't one */
+extern ConsoleReplayRef ConsoleReplay_Open(ConsoleRef console, const char* path);
+extern void ConsoleReplay_Close(ConsoleReplayRef replay);
+/* frame of the next command - returns 0 once all have run */
+extern int ConsoleReplay_NextFrame(ConsoleReplayRef replay, unsigned int* outFrame);
+/* run commands recorded at or before frame - returns commands run */
+extern int ConsoleReplay_RunFrame(ConsoleReplayRef replay, unsigned int frame);
+
+#ifdef CONSOLE_PROFILE
+/* copy the stats of a command - returns 0 if it doesn't exist */
+extern int Console_GetStats(ConsoleRef console, const char* commandName, ConsoleCommandStats_t* outStats);
+extern void Console_ResetStats(ConsoleRef console);
+/* upper bound of the duration under which fraction (0 to 1) of samples fall */
+extern unsigned long long ConsoleHistogram_Percentile(const ConsoleHistogram_t* histogram, double fraction);
+#endif
+
+#ifndef CONSOLE_NO_THREADS
+/*
+ submit a command from any thread without blocking.
+ returns 1 if queued, 0 if the queue is full and a retry may succeed,
+ or -1 if the command is longer than CONSOLE_QUEUE_COMMAND_MAX allows
+ */
+extern int Console_Enqueue(ConsoleRef console, const char* command);
+
+/*
+ execute queued commands on the console thread.
+ stops after maxCommands commands or maxMicroseconds, whichever
+ comes first (values <= 0 mean no limit) - returns commands executed
+ */
+extern int Console_DrainQueue(ConsoleRef console, int maxCommands, int maxMicroseconds);
+
+/*
+ a ring of recent output lines written by one thread and read
+ by any number of others without copying. when full the oldest
+ lines are overwritten. pass ConsoleLogRing_Write and the ring
+ to Console_SetOutput
+ */
+typedef struct ConsoleLogRing* ConsoleLogRingRef;
+
+/* byteBudget is the size of the text buffer, rounded up to a power of 2 */
+extern ConsoleLogRingRef ConsoleLogRing_Create(size_t byteBudget);
+extern void ConsoleLogRing_Destroy(ConsoleLogRingRef ring);
+/* a ConsoleOutputFunc_t - only one thread may write at a time */
+extern void ConsoleLogRing_Write(const char* text, size_t length, void* ring);
+
+/* one past the newest complete line, line numbers only increase */
+extern unsigned long long ConsoleLogRing_LineCount(ConsoleLogRingRef ring);
+/*
+ keep lines from being overwritten while reading them.
+ returns the oldest readable line >= from. one reader per ring
+ may hold a read at a time
+ */
+extern unsigned long long ConsoleLogRing_BeginRead(ConsoleLogRingRef ring, unsigned long long from);
+/* text of a line between BeginRead and EndRead, not null terminated */
+extern const char* ConsoleLogRing_Line(ConsoleLogRingRef ring, unsigned long long line, size_t* length);
+extern void ConsoleLogRing_EndRead(ConsoleLogRingRef ring);
+/* lines lost because a reader held them */
+extern unsigned long long ConsoleLogRing_Dropped(ConsoleLogRingRef ring);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
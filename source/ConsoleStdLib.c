@@ -8,12 +8,13 @@
 
 #include "ConsoleStdLib.h"
 #include <math.h>
+#include <string.h>
 
-static int _Console_Inspect(ConsoleRef console, ConsoleArgRef arg)
+static int _Console_Inspect(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
 {
     const char* typeString = "unknown";
     
-    switch (ConsoleVar_Type(arg->var))
+    switch (argv[0].type)
     {
         case kConsoleVarTypeString:
             typeString = "string";
@@ -31,73 +32,111 @@ static int _Console_Inspect(ConsoleRef console, ConsoleArgRef arg)
             break;
     }
     
-    fprintf(Console_Log(console), "var type: %s\n", typeString);
+    Console_Printf(console, "var type: %s\n", typeString);
     
     return 1;
 }
 
-static int _Console_Echo(ConsoleRef console, ConsoleArgRef arg)
+static int _Console_Echo(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
 {
-    switch (ConsoleVar_Type(arg->var))
+    char number[CONSOLE_NUMBER_STRING_MAX];
+    const char* text = "";
+    
+    switch (argv[0].type)
     {
         case kConsoleVarTypeString:
-            fprintf(Console_Log(console), "%s\n", ConsoleVar_StringValue(arg->var));
+            text = argv[0].value.stringValue;
             break;
         case kConsoleVarTypeInt:
-            fprintf(Console_Log(console), "%i\n", ConsoleVar_IntValue(arg->var));
+            Console_FormatInt(argv[0].value.intValue, number);
+            text = number;
             break;
         case kConsoleVarTypeDouble:
-            fprintf(Console_Log(console), "%lf\n", ConsoleVar_DoubleValue(arg->var));
+            Console_FormatDouble(argv[0].value.doubleValue, number);
+            text = number;
             break;
         case kConsoleVarTypeBool:
-            
-            if (ConsoleVar_IntValue(arg->var))
-            {
-                fprintf(Console_Log(console), "TRUE\n");
-            }
-            else
-            {
-                fprintf(Console_Log(console), "FALSE\n");
-            }
-            
+            text = argv[0].value.intValue ? "TRUE" : "FALSE";
             break;
         default:
             break;
     }
     
+    Console_Write(console, text, strlen(text));
+    Console_Write(console, "\n", 1);
+    
     return 1;
 }
 
 
 
-static int _Console_Set(ConsoleRef console, ConsoleArgRef arg)
+static void _Console_ListName(const char* name, unsigned int symbols, void* context)
 {
-    ConsoleArgRef first = arg;
-    ConsoleArgRef second = arg->next;
+    ConsoleRef console = context;
+    Console_Printf(console, "%s%s\n", name, (symbols & kConsoleSymbolCommand) ? " ()" : "");
+}
+
+static int _Console_List(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    if (argc > 1)
+    {
+        return 0;
+    }
+    
+    const char* pattern = "*";
     
-    if (!first || !second)
+    if (argc == 1)
+    {
+        if (argv[0].var)
+        {
+            /* an unquoted var name lists itself */
+            pattern = ConsoleVar_Name(argv[0].var);
+        }
+        else if (argv[0].type == kConsoleVarTypeString)
+        {
+            pattern = argv[0].value.stringValue;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    
+    int matches = Console_List(console, pattern, _Console_ListName, console);
+    Console_Printf(console, "%i matches\n", matches);
+    
+    return 1;
+}
+
+static int _Console_Set(ConsoleRef console, int argc, const ConsoleArgView_t* argv)
+{
+    ConsoleVarRef target = argv[0].var;
+    const ConsoleArgView_t* source = &argv[1];
+    
+    /* literals can't be assigned */
+    if (!target)
     {
         return 0;
     }
     
-    if (ConsoleVar_Readonly(first->var))
+    if (ConsoleVar_Readonly(target))
     {
         return 0;
     }
     
-    switch (ConsoleVar_Type(first->var))
+    switch (ConsoleVar_Type(target))
     {
         case kConsoleVarTypeString:
-            ConsoleVar_SetStringValue(first->var, ConsoleVar_StringValue(second->var));
+            ConsoleVar_SetStringValue(target, ConsoleArgView_StringValue(source));
             break;
         case kConsoleVarTypeDouble:
-            ConsoleVar_SetDoubleValue(first->var, ConsoleVar_DoubleValue(second->var));
+            ConsoleVar_SetDoubleValue(target, ConsoleArgView_DoubleValue(source));
             break;
         case kConsoleVarTypeInt:
-            ConsoleVar_SetIntValue(first->var, ConsoleVar_IntValue(second->var));
+            ConsoleVar_SetIntValue(target, ConsoleArgView_IntValue(source));
             break;
         case kConsoleVarTypeBool:
-            ConsoleVar_SetIntValue(first->var, ConsoleVar_IntValue(second->var));
+            ConsoleVar_SetIntValue(target, ConsoleArgView_IntValue(source));
             break;
             
         default:
@@ -122,19 +161,24 @@ void ConsoleStdLib_Register(ConsoleRef console)
                                                kConsoleVarFlagReadonly);
     ConsoleVar_SetIntValue(vFalse, 0);
     
-    Console_RegisterCommand(console,
-                            "inspect",
-                            _Console_Inspect,
-                            1);
+    Console_RegisterCommandArgv(console,
+                                "inspect",
+                                _Console_Inspect,
+                                1);
+    
+    Console_RegisterCommandArgv(console,
+                                "echo",
+                                _Console_Echo,
+                                1);
     
-    Console_RegisterCommand(console,
-                            "echo",
-                            _Console_Echo,
-                            1);
+    Console_RegisterCommandArgv(console,
+                                "set",
+                                _Console_Set,
+                                2);
     
-    Console_RegisterCommand(console,
-                            "set",
-                            _Console_Set,
-                            2);
+    Console_RegisterCommandArgv(console,
+                                "list",
+                                _Console_List,
+                                -1);
     
 }